@@ -9,6 +9,16 @@
 //--------------------------------------------------------------------- INCLUDE
 #include "Application.h"
 
+//---------------------------------------------------------------------- CONSTS
+
+/* Tolerance of ComparePipelines. A pixel of the fixed point frame matches if
+	the float frame has the same value at most PIPELINE_MAX_SHIFT pixels away :
+	edges and texel boundaries moved by the rounding of the 16.16 coordinates.
+	A view fails if more than PIPELINE_MAX_MISMATCH pixels per million don't
+	match. */
+#define PIPELINE_MAX_SHIFT			1
+#define PIPELINE_MAX_MISMATCH		100
+
 //----------------------------------------------------------------------- TYPES
 
 //--------------------------------------------------------------------- CLASSES
@@ -26,6 +36,8 @@ Application& Application::Instance()
 
 Application::Application()
 {
+	obj=NULL;
+	obj2=NULL;
 	xRotation=false;
 	yRotation=false;
 	zRotation=false;
@@ -113,6 +125,84 @@ bool Application::msgLoop()
 				case SDLK_w:
 					RenderingMode ^= WIREFRAME;
 					break;
+				case SDLK_s:
+				{
+					// Cycle through the depth sorting algorithms
+					DepthSorter& sorter = renderer->GetDepthSorter();
+					sorter.SetMode((DepthSorter::SORT_MODE)((sorter.GetMode()+1) % DepthSorter::NUM_SORT_MODES));
+					printf("Depth sort : %s\n", sorter.GetModeName());
+					break;
+				}
+				case SDLK_h:
+					// Switch the hidden surface removal algorithm
+					renderer->SetHSRMode((renderer->GetHSRMode()+1) % Renderer::NUM_HSR_MODES);
+					printf("Hidden surface removal : %d\n", renderer->GetHSRMode());
+					break;
+				case SDLK_d:
+					renderer->SetDepthFormat(renderer->GetDepthFormat() == Renderer::DEPTH_16 ?
+						Renderer::DEPTH_32 : Renderer::DEPTH_16);
+					break;
+				case SDLK_r:
+					// Switch between immediate and tiled multithreaded rasterization
+					renderer->SetRasterThreads(renderer->GetRasterThreads() ? 0 : TileBinner::GetNumCPUs());
+					printf("Raster threads : %d\n", renderer->GetRasterThreads());
+					break;
+				case SDLK_c:
+					// Switch between the scanline and the half-space rasterizers
+					renderer->SetRasterCore((renderer->GetRasterCore()+1) % Renderer::NUM_RASTER_CORES);
+					printf("Raster core : %d\n", renderer->GetRasterCore());
+					break;
+				case SDLK_b:
+				{
+					// Cycle through the face culling modes
+					static const char* names[Renderer::NUM_FACE_CULLINGS] = {"none", "back", "front"};
+					renderer->SetFaceCulling((renderer->GetFaceCulling()+1) % Renderer::NUM_FACE_CULLINGS);
+					printf("Face culling : %s\n", names[renderer->GetFaceCulling()]);
+					break;
+				}
+				case SDLK_l:
+					renderer->SetMipmapping(!renderer->GetMipmapping());
+					printf("Mipmapping : %s\n", renderer->GetMipmapping() ? "on" : "off");
+					break;
+				case SDLK_g:
+				{
+					// Switch between the linear and the tiled texture layouts
+					TextureManager& textures = TextureManager::Instance();
+					textures.SetLayout(textures.GetLayout() == TEXTURE_LINEAR ? TEXTURE_TILED : TEXTURE_LINEAR);
+					printf("Texture layout : %s\n", textures.GetLayout() == TEXTURE_LINEAR ? "linear" : "tiled");
+					break;
+				}
+				case SDLK_i:
+				{
+					// Cycle through the instruction sets of the span kernels and of the transforms
+					SpanFiller& filler = renderer->GetSpanFiller();
+					filler.SetISA(filler.GetISA() == SpanFiller::GetBestISA() ? SpanFiller::SCALAR : filler.GetISA()+1);
+					Mat4x4::setISA(Mat4x4::getISA() == Mat4x4::getBestISA() ? Mat4x4::SCALAR : Mat4x4::getISA()+1);
+					printf("Span kernels : %s, transforms : %s\n", SpanFiller::GetISAName(filler.GetISA()),
+							 Mat4x4::getISAName(Mat4x4::getISA()));
+					break;
+				}
+				case SDLK_k:
+					SpanFiller::Benchmark();
+					DepthSorter::Benchmark();
+					Mat4x4::benchmark();
+					Mat4x3::benchmark();
+					Object::BenchmarkMeshLoaders();
+					renderer->BenchmarkPerspective(obj->textureID);
+					renderer->BenchmarkSetup();
+					ComparePipelines();
+					break;
+				case SDLK_a:
+					// Cycle through affine, perspective every 16 and every 8 pixels
+					if(renderer->GetPerspective() == 0)
+						renderer->SetPerspective(16);
+					else
+					if(renderer->GetPerspective() > 8)
+						renderer->SetPerspective(8);
+					else
+						renderer->SetPerspective(0);
+					printf("Perspective span : %d\n", renderer->GetPerspective());
+					break;
 				case SDLK_x:
 					xRotation=!xRotation;
 					break;
@@ -205,7 +295,7 @@ int Application::Start()
 	obj->body.v.y=-0.1f;
 	obj->body.a.y=-0.1f;
 
-	Object* obj2=new Object;
+	obj2=new Object;
 	if(obj2->GetMesh(XML_FILE2)<0)
 	{
 		printf("Error while loading %s\n", XML_FILE2);
@@ -237,6 +327,7 @@ int Application::Start()
 		if(!pause)
 		{
 			display->Clear();
+			renderer->BeginFrame();
 
 			// Calculate passed time in seconds for proper rotation (at fixed speed)
 	    	dword currTicks = GetTimer();
@@ -255,7 +346,12 @@ int Application::Start()
 #ifdef GP2X_MODE
                 gp2x_printf(NULL, 0, 0,"%i fps",maxfps);
 #else
-					printf("%d fps\n",maxfps);
+				{
+					const FrameStats &stats = renderer->GetFrameStats();
+					printf("%d fps, %d/%d objects culled, %d/%d faces culled, %ld texels, %d texture switches, %ld KB scratch\n",
+							 maxfps, stats.numCulled, stats.numObjects, stats.numFacesCulled, stats.numFacesTested,
+							 stats.numTexels, stats.numTextureSwitches, stats.scratchHighWater / 1024);
+				}
 #endif //GP2X_MODE
             }
             
@@ -267,18 +363,137 @@ int Application::Start()
 			if(zRotation)
 				vecRot.z += 40.0 * secs;
 
-			renderer->Identity();
-			renderer->Translate(vecTrans);
-			renderer->Rotate(vecRot);
-
-			// render the objects
-			renderer->RenderObject(obj);
-			renderer->RenderObject(obj2);
+			drawScene(vecTrans, vecRot);
 
 			//obj->body.Update();
 
+			renderer->EndFrame();
 			display->Flip();	
 		}
 	}
 	return 0;
+}
+
+// Submit the objects of the scene seen from trans and rot
+void Application::drawScene(const Vector3& trans, const Vector3& rot)
+{
+	renderer->Identity();
+	renderer->Translate(trans);
+	renderer->Rotate(rot);
+
+	// render the objects, sorted by texture at the end of the frame
+	renderer->SubmitObject(obj);
+	renderer->SubmitObject(obj2);
+}
+
+#ifdef FIXED_PIPELINE
+/* Distance to the nearest pixel of image having the value of the pixel (x,y)
+	of other, up to maxShift. Returns maxShift+1 if there is none. */
+static int pixelShift(const Pixel *image, const Pixel *other, int x, int y, int maxShift)
+{
+	Pixel p = other[y*SCR_WIDTH + x];
+	for(int d = 0; d <= maxShift; d++)
+	{
+		for(int j = MAX(y - d, 0); j <= MIN(y + d, SCR_HEIGHT - 1); j++)
+		{
+			for(int i = MAX(x - d, 0); i <= MIN(x + d, SCR_WIDTH - 1); i++)
+			{
+				if(image[j*SCR_WIDTH + i] == p)
+					return d;
+			}
+		}
+	}
+	return maxShift + 1;
+}
+#endif
+
+/* Render the scene from a few reference views with the float and the fixed
+	point pipelines, and print the number of pixels which differ and the time
+	of a frame in each mode. The last view crosses the near plane. Each frame
+	is rendered during a quarter of second.
+	The fixed frame must match the float one within PIPELINE_MAX_SHIFT and
+	PIPELINE_MAX_MISMATCH, otherwise the view is reported as FAILED.
+	The pipelines are only compared on the build's own FPU : a soft-float x86
+	build can't be made with this toolchain (x86-64 gcc keeps the SSE float
+	arithmetic with -msoft-float, -mno-sse fails on the float returns of the
+	ABI and there is no 32 bit multilib), so the speed of the fixed pipeline
+	without FPU has to be measured on the GP2X. */
+void Application::ComparePipelines()
+{
+#ifdef FIXED_PIPELINE
+	// Translation z, then rotation x, y, z
+	static const float views[][4] = {
+		{3.0f, 0.0f, 0.0f, 0.0f},
+		{3.0f, 30.0f, 45.0f, 10.0f},
+		{8.0f, -60.0f, 120.0f, 0.0f},
+		{1.0f, 90.0f, 0.0f, 0.0f},
+		{0.3f, 20.0f, 30.0f, 0.0f}};
+	static const int numViews = sizeof(views) / sizeof(views[0]);
+
+	Screen screen = display->GetScreen();
+	Pixel *floatImage = new Pixel[SCR_WIDTH*SCR_HEIGHT];
+	bool fixed = renderer->GetFixedPipeline();
+	int failed = 0;
+
+	for(int i = 0; i < numViews; i++)
+	{
+		Vector3 trans(0, 0, views[i][0]);
+		Vector3 rot(views[i][1], views[i][2], views[i][3]);
+		double ms[2];
+
+		for(int mode = 0; mode < 2; mode++)
+		{
+			renderer->SetFixedPipeline(mode == 1);
+
+			int frames = 0;
+			clock_t start = clock(), end;
+			do
+			{
+				display->Clear();
+				renderer->BeginFrame();
+				drawScene(trans, rot);
+				renderer->EndFrame();
+				frames++;
+				end = clock();
+			} while(end - start < CLOCKS_PER_SEC / 4);
+
+			ms[mode] = 1000.0 * (end - start) / CLOCKS_PER_SEC / frames;
+			if(mode == 0)
+				memcpy(floatImage, screen, SCR_WIDTH*SCR_HEIGHT*sizeof(Pixel));
+		}
+
+		// Pixels which differ, and those which don't match
+		long differ = 0, mismatch = 0;
+		for(int y = 0; y < SCR_HEIGHT; y++)
+		{
+			for(int x = 0; x < SCR_WIDTH; x++)
+			{
+				if(screen[y*SCR_WIDTH + x] == floatImage[y*SCR_WIDTH + x])
+					continue;
+				differ++;
+
+				if(pixelShift(floatImage, screen, x, y, PIPELINE_MAX_SHIFT) > PIPELINE_MAX_SHIFT)
+					mismatch++;
+			}
+		}
+
+		long limit = (long)SCR_WIDTH*SCR_HEIGHT*PIPELINE_MAX_MISMATCH / 1000000;
+		bool pass = mismatch <= limit;
+		if(!pass)
+			failed++;
+
+		printf("Pipelines view %d : %6ld pixels differ, %4ld don't match (max %ld), float %6.2f ms, fixed %6.2f ms %s\n",
+				 i, differ, mismatch, limit, ms[0], ms[1], pass ? "ok" : "FAILED");
+	}
+
+	if(failed)
+		printf("Pipelines : FAILED, %d view(s) out of %d beyond the tolerance\n", failed, numViews);
+	else
+		printf("Pipelines : ok\n");
+
+	renderer->SetFixedPipeline(fixed);
+	delete[] floatImage;
+#else
+	printf("Pipelines : only the float pipeline is compiled (FIXED_PIPELINE)\n");
+#endif
 }
\ No newline at end of file
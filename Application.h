@@ -14,6 +14,7 @@
 #include "Display.h"
 #include "Object.h"
 #include "Renderer.h"
+#include "TileBinner.h"
 #include "Ase.h"
 
 #include <string.h>
@@ -25,7 +26,6 @@
 
 #ifdef GP2X_MODE
 #include "minimal.h"
-#include "math-sll.h"
 #endif //GP2X_MODE
 
 //----------------------------------------------------------------------- TYPES
@@ -46,6 +46,7 @@ private:
 
 	Display*		display;		// Application's display object
 	Object*		obj;			// Application's display object
+	Object*		obj2;			// second object of the scene
 	Renderer*	renderer;	// our 3D renderer
 
 	Vector3 vecRot;			// rotation vector applied to the scene
@@ -67,6 +68,7 @@ private:
 	void init();
 	void deinit();
 	bool msgLoop();	
+	void drawScene(const Vector3& trans, const Vector3& rot);
 
 public:
 	enum MODE {
@@ -80,6 +82,7 @@ public:
 	Vector3& GetRotation();
 	dword GetTimer();
 	int Start();	
+	void ComparePipelines();
 	
 	static Application& Instance();
 };
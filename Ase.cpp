@@ -427,7 +427,8 @@ void CLoadASE::ReadObjectInfo(Object *pObject, int desiredObject)
 			fscanf(m_FilePointer, "%d", &pObject->numVerts);
 
             // Allocate enough memory to hold the vertices
-            pObject->verts = new Vertex [pObject->numVerts];
+            pObject->arrays.Alloc(pObject->numVerts);
+            pObject->arrays.ClearInputs();
         }
         // If we hit the number of faces tag
         else if (!strcmp(strWord, NUM_FACES))
@@ -530,6 +531,10 @@ void CLoadASE::ReadObjectData(t3DModel *pModel, Object *pObject, int desiredObje
 
     // Load the V tile for this object
     GetData(pModel, pObject, VTILE,      desiredObject);
+
+    // The vertices won't change anymore, compute the bounding volumes for culling
+    pObject->arrays.Finish();
+    calcBounds(pObject->arrays, &pObject->bounds);
 }
 
 
@@ -636,9 +641,9 @@ void CLoadASE::ReadVertex(Object *pObject)
     // Read past the vertex index
     fscanf(m_FilePointer, "%d", &index);
 	
-	fscanf(m_FilePointer, "%f %f %f", &pObject->verts[index].coordsLocal.x, 
-                                      &pObject->verts[index].coordsLocal.y,
-                                      &pObject->verts[index].coordsLocal.z);
+	fscanf(m_FilePointer, "%f %f %f", &pObject->arrays.x[index], 
+                                      &pObject->arrays.y[index],
+                                      &pObject->arrays.z[index]);
 }
 
 
@@ -0,0 +1,406 @@
+/**
+* File : DepthSort.cpp
+* Description : Depth ordering of the faces of an object (painter's algorithm)
+*
+* Author(s) : ALucchi
+* Date of creation : 17/10/2026
+* Modification(s) :
+*/
+
+//-------------------------------------------------------------------- INCLUDES
+#include "DepthSort.h"
+#include "Object.h"
+#include <stdlib.h>
+#include <time.h>
+#include <algorithm>
+
+//------------------------------------------------------------------- FUNCTIONS
+
+/* Average time of a sort, in ms : order is reset to start before each sort,
+	which is repeated during a quarter of second (at least once) */
+static double timeSort(DepthSorter &sorter, const float *depths, const int *start, int *order, int num)
+{
+	int runs = 0;
+	clock_t begin = clock(), end;
+
+	do
+	{
+		memcpy(order, start, num * sizeof(int));
+		sorter.Sort(depths, sizeof(float), order, num);
+		runs++;
+		end = clock();
+	} while(end - begin < CLOCKS_PER_SEC / 4);
+
+	return 1000.0 * (end - begin) / CLOCKS_PER_SEC / runs;
+}
+
+// Number of faces drawn before a farther one
+static int countMisordered(const float *depths, const int *order, int num)
+{
+	int count = 0;
+	for(int i = 1; i < num; i++)
+	{
+		if(depths[order[i]] > depths[order[i-1]])
+			count++;
+	}
+	return count;
+}
+
+//--------------------------------------------------------------------- CLASSES
+
+// Comparison of std::sort : the farthest face first
+struct FartherFirst
+{
+	const char	*base;
+	int		stride;
+
+	FartherFirst(const char *b, int s) : base(b), stride(s) {}
+
+	inline bool operator()(int a, int b) const
+	{
+		return *(const float*)(base + a*stride) > *(const float*)(base + b*stride);
+	}
+};
+
+DepthSorter::DepthSorter()
+{
+	mode = RADIX;
+	numBuckets = DEFAULT_NUM_BUCKETS;
+
+	capacity = 0;
+	keys = NULL;
+	tmpKeys = NULL;
+	tmpOrder = NULL;
+	counts = new int[MAX_NUM_BUCKETS+1];
+
+	depthBase = NULL;
+	depthStride = 0;
+}
+
+DepthSorter::~DepthSorter()
+{
+	delete[] keys;
+	delete[] tmpKeys;
+	delete[] tmpOrder;
+	delete[] counts;
+}
+
+void DepthSorter::SetMode(SORT_MODE m)
+{
+	mode = m;
+}
+
+DepthSorter::SORT_MODE DepthSorter::GetMode() const
+{
+	return mode;
+}
+
+const char* DepthSorter::GetModeName() const
+{
+	switch(mode)
+	{
+		case SELECTION:	return "selection";
+		case RADIX:			return "radix";
+		case BUCKET:		return "bucket";
+		case COHERENT:		return "coherent";
+		default:				return "unknown";
+	}
+}
+
+void DepthSorter::SetNumBuckets(int num)
+{
+	numBuckets = CLAMP(num, 1, MAX_NUM_BUCKETS);
+}
+
+int DepthSorter::GetNumBuckets() const
+{
+	return numBuckets;
+}
+
+void DepthSorter::Sort(const Triangle* faces, int* order, int num)
+{
+	Sort(&faces[0].cenZ, sizeof(Triangle), order, num);
+}
+
+void DepthSorter::Sort(const float* depths, int stride, int* order, int num)
+{
+	if(num < 2)
+		return;
+
+	depthBase = (const char*)depths;
+	depthStride = stride;
+
+	switch(mode)
+	{
+		case SELECTION:
+			selectionSort(order, num);
+			break;
+		case RADIX:
+			radixSort(order, num);
+			break;
+		case BUCKET:
+			bucketSort(order, num);
+			break;
+		case COHERENT:
+		default:
+			// order already holds the result of the previous frame
+			insertionSort(order, num);
+			break;
+	}
+}
+
+void DepthSorter::reserve(int num)
+{
+	if(num <= capacity)
+		return;
+
+	delete[] keys;
+	delete[] tmpKeys;
+	delete[] tmpOrder;
+
+	capacity = num;
+	keys = new word[capacity];
+	tmpKeys = new word[capacity];
+	tmpOrder = new int[capacity];
+}
+
+/* Quantize the z centroids into [0,range]. The farthest face gets the key 0,
+	so that sorting the keys in increasing order gives a back to front order. */
+void DepthSorter::quantize(const int* order, int num, int range)
+{
+	float minZ = depth(order[0]);
+	float maxZ = minZ;
+
+	for(int i = 1; i < num; i++)
+	{
+		float z = depth(order[i]);
+		if(z < minZ)
+			minZ = z;
+		if(z > maxZ)
+			maxZ = z;
+	}
+
+	float scale = 0;
+	if(maxZ - minZ > FLT_ERROR)
+		scale = (float)range / (maxZ - minZ);
+
+	for(int i = 0; i < num; i++)
+	{
+		keys[i] = (word)((maxZ - depth(order[i])) * scale);
+	}
+}
+
+void DepthSorter::selectionSort(int* order, int num)
+{
+	int pos;
+	for(int i = 0; i < num - 1; i++)
+	{
+		pos = i;
+
+		for(int j = i + 1; j < num; j++)
+		{
+			if(depth(order[j]) > depth(order[pos]))
+				pos = j;
+		}
+
+		if(pos != i)
+		{
+			int temp = order[i];
+			order[i] = order[pos];
+			order[pos] = temp;
+		}
+	}
+}
+
+/* Two passes of 8 bits. Each pass is stable so the second one keeps the
+	order of the low byte for equal high bytes. */
+void DepthSorter::radixSort(int* order, int num)
+{
+	reserve(num);
+	quantize(order, num, 0xFFFF);
+
+	word *srcKeys = keys, *dstKeys = tmpKeys;
+	int *srcOrder = order, *dstOrder = tmpOrder;
+
+	for(int shift = 0; shift < 16; shift += 8)
+	{
+		memset(counts, 0, 256 * sizeof(int));
+
+		for(int i = 0; i < num; i++)
+			counts[(srcKeys[i] >> shift) & 0xFF]++;
+
+		int sum = 0;
+		for(int i = 0; i < 256; i++)
+		{
+			int c = counts[i];
+			counts[i] = sum;
+			sum += c;
+		}
+
+		for(int i = 0; i < num; i++)
+		{
+			int pos = counts[(srcKeys[i] >> shift) & 0xFF]++;
+			dstKeys[pos] = srcKeys[i];
+			dstOrder[pos] = srcOrder[i];
+		}
+
+		word *tk = srcKeys; srcKeys = dstKeys; dstKeys = tk;
+		int *to = srcOrder; srcOrder = dstOrder; dstOrder = to;
+	}
+
+	// After an even number of passes the result is back in order
+}
+
+/* Distribute the faces in numBuckets buckets of equal depth range, then
+	sort each bucket : the insertion sort is linear on the few faces of a
+	bucket, std::sort takes the buckets holding more than BUCKET_MAX_FACES */
+void DepthSorter::bucketSort(int* order, int num)
+{
+	reserve(num);
+	quantize(order, num, numBuckets - 1);
+
+	memset(counts, 0, numBuckets * sizeof(int));
+
+	for(int i = 0; i < num; i++)
+		counts[keys[i]]++;
+
+	int sum = 0;
+	for(int i = 0; i < numBuckets; i++)
+	{
+		int c = counts[i];
+		counts[i] = sum;
+		sum += c;
+	}
+
+	for(int i = 0; i < num; i++)
+		tmpOrder[counts[keys[i]]++] = order[i];
+
+	memcpy(order, tmpOrder, num * sizeof(int));
+
+	// counts[i] is now the end of the bucket i
+	int start = 0;
+	for(int i = 0; i < numBuckets; i++)
+	{
+		int size = counts[i] - start;
+		if(size > BUCKET_MAX_FACES)
+			std::sort(order + start, order + counts[i], FartherFirst(depthBase, depthStride));
+		else
+			insertionSort(order + start, size);
+		start = counts[i];
+	}
+}
+
+/* Linear on nearly sorted input, e.g. the order of the previous frame */
+void DepthSorter::insertionSort(int* order, int num)
+{
+	for(int i = 1; i < num; i++)
+	{
+		int index = order[i];
+		float z = depth(index);
+		int j = i - 1;
+
+		while(j >= 0 && depth(order[j]) < z)
+		{
+			order[j+1] = order[j];
+			j--;
+		}
+		order[j+1] = index;
+	}
+}
+
+/* The faces have random depths in [1,100], or form a wall : depths in
+	[50,50.01] but for two faces at 1 and 100, so that the quantization puts
+	the wall in one bucket. COHERENT starts from the order of the previous
+	frame, the same faces moved by at most 0.01 (0.0001 for the wall), the
+	other modes from the identity. RADIX and BUCKET only sort quantized
+	depths : the faces misordered by the quantization are counted.
+	SELECTION is quadratic, it is only run up to BENCHMARK_MAX_SELECTION
+	faces and its time is extrapolated above (about 40 s on 100k faces on a
+	PC). */
+void DepthSorter::Benchmark(void)
+{
+#ifdef GP2X_MODE
+	static const int sizes[] = {1000, 10000};
+#else
+	static const int sizes[] = {1000, 10000, 100000};
+#endif
+	static const int numSizes = sizeof(sizes) / sizeof(sizes[0]);
+	static const char* scenes[] = {"random", "wall"};
+
+	DepthSorter sorter;
+	srand(1);
+
+	for(int scene = 0; scene < 2; scene++)
+	{
+		double selectionMs = 0;
+		int selectionNum = 0;
+
+		for(int s = 0; s < numSizes; s++)
+		{
+			int num = sizes[s];
+			float *previous = new float[num];
+			float *depths = new float[num];
+			int *identity = new int[num];
+			int *previousOrder = new int[num];
+			int *order = new int[num];
+
+			for(int i = 0; i < num; i++)
+			{
+				if(scene == 0)
+				{
+					previous[i] = 1.0f + 99.0f * rand() / RAND_MAX;
+					depths[i] = previous[i] + 0.02f * rand() / RAND_MAX - 0.01f;
+				}
+				else
+				{
+					previous[i] = 50.0f + 0.01f * rand() / RAND_MAX;
+					depths[i] = previous[i] + 0.0002f * rand() / RAND_MAX - 0.0001f;
+				}
+				identity[i] = previousOrder[i] = i;
+			}
+			if(scene == 1)
+			{
+				previous[0] = depths[0] = 1.0f;
+				previous[1] = depths[1] = 100.0f;
+			}
+
+			// Exact order of the previous frame : radix, then insertion sort
+			sorter.SetMode(RADIX);
+			sorter.Sort(previous, sizeof(float), previousOrder, num);
+			sorter.SetMode(COHERENT);
+			sorter.Sort(previous, sizeof(float), previousOrder, num);
+
+			for(int m = SELECTION; m < NUM_SORT_MODES; m++)
+			{
+				sorter.SetMode((SORT_MODE)m);
+
+				if(m == SELECTION && num > BENCHMARK_MAX_SELECTION)
+				{
+					double ms = selectionMs * ((double)num / selectionNum) * ((double)num / selectionNum);
+					printf("Depth sort %-6s %6d faces : %-9s %9.3f ms (extrapolated)\n", scenes[scene], num,
+							 sorter.GetModeName(), ms);
+					selectionMs = ms;
+					selectionNum = num;
+					continue;
+				}
+
+				double ms = timeSort(sorter, depths, m == COHERENT ? previousOrder : identity, order, num);
+				if(m == SELECTION)
+				{
+					selectionMs = ms;
+					selectionNum = num;
+				}
+
+				printf("Depth sort %-6s %6d faces : %-9s %9.3f ms (x%6.1f), %d misordered\n", scenes[scene], num,
+						 sorter.GetModeName(), ms, ms > 0 ? selectionMs / ms : 0.0,
+						 countMisordered(depths, order, num));
+			}
+
+			delete[] previous;
+			delete[] depths;
+			delete[] identity;
+			delete[] previousOrder;
+			delete[] order;
+		}
+	}
+}
@@ -0,0 +1,94 @@
+/**
+* File : DepthSort.h
+* Description : Depth ordering of the faces of an object (painter's algorithm)
+*
+* Author(s) : ALucchi
+* Date of creation : 17/10/2026
+* Modification(s) :
+*/
+
+#ifndef DEPTH_SORT_H
+#define DEPTH_SORT_H
+
+//-------------------------------------------------------------------- INCLUDES
+#include "defs.h"
+
+//---------------------------------------------------------------------- CONSTS
+
+#define DEFAULT_NUM_BUCKETS	1024
+#define MAX_NUM_BUCKETS		65536
+
+/* Buckets holding more faces (e.g. a wall at a constant depth) are sorted
+	with std::sort, the insertion sort being quadratic */
+#define BUCKET_MAX_FACES		256
+
+// SELECTION is quadratic : its time is extrapolated above this size
+#define BENCHMARK_MAX_SELECTION	10000
+
+//--------------------------------------------------------------------- CLASSES
+
+/* Sort face indices by decreasing Triangle::cenZ (the farthest face first).
+	Every algorithm sorts the same index array, so they can be switched at
+	runtime. Any array of structures holding a depth can be sorted, see the
+	second Sort. */
+class DepthSorter
+{
+public:
+	enum SORT_MODE {
+		SELECTION,		// O(n^2) selection sort (reference)
+		RADIX,			// LSD radix sort on 16 bits quantized keys
+		BUCKET,			// bucket sort, then sort inside each bucket
+		COHERENT,		// insertion sort on the order of the previous frame
+		NUM_SORT_MODES};
+
+	DepthSorter();
+	~DepthSorter();
+
+	void SetMode(SORT_MODE mode);
+	SORT_MODE GetMode() const;
+	const char* GetModeName() const;
+
+	void SetNumBuckets(int num);
+	int GetNumBuckets() const;
+
+	// Sort the num indices of order according to the z centroid of the faces
+	void Sort(const Triangle* faces, int* order, int num);
+
+	/* Same with the depth of the element i at depths + i*stride (stride in
+		bytes) */
+	void Sort(const float* depths, int stride, int* order, int num);
+
+	/* Print the time of each mode, and its speedup over SELECTION, on 1k,
+		10k and 100k random faces and on a wall of faces at the same depth */
+	static void Benchmark(void);
+
+private:
+	SORT_MODE	mode;
+	int		numBuckets;
+
+	// scratch buffers, only grown when needed
+	int		capacity;
+	word		*keys;
+	word		*tmpKeys;
+	int		*tmpOrder;
+	int		*counts;
+
+	// depths being sorted
+	const char	*depthBase;
+	int		depthStride;
+
+	inline float depth(int index) const
+	{
+		return *(const float*)(depthBase + index*depthStride);
+	}
+
+	void reserve(int num);
+	void quantize(const int* order, int num, int range);
+
+	void selectionSort(int* order, int num);
+	void radixSort(int* order, int num);
+	void bucketSort(int* order, int num);
+	void insertionSort(int* order, int num);
+};
+
+#endif // DEPTH_SORT_H
@@ -0,0 +1,114 @@
+/**
+* File : FrameArena.cpp
+* Description : Linear allocator for the temporary buffers of a frame
+*
+* Author(s) : ALucchi
+* Date of creation : 17/10/2026
+* Modification(s) :
+*/
+
+//-------------------------------------------------------------------- INCLUDES
+#include "FrameArena.h"
+
+//------------------------------------------------------------------- FUNCTIONS
+
+static inline size_t alignSize(size_t size)
+{
+	return (size + FRAME_ARENA_ALIGN - 1) & ~(size_t)(FRAME_ARENA_ALIGN - 1);
+}
+
+static inline char* alignPointer(char *p)
+{
+	return (char*)(((size_t)p + FRAME_ARENA_ALIGN - 1) & ~(size_t)(FRAME_ARENA_ALIGN - 1));
+}
+
+//--------------------------------------------------------------------- CLASSES
+
+FrameArena::FrameArena(size_t size)
+{
+	block = NULL;
+	base = NULL;
+	capacity = 0;
+	used = 0;
+	highWater = 0;
+	Reserve(size);
+}
+
+FrameArena::~FrameArena()
+{
+	Reset();
+	delete[] block;
+}
+
+void* FrameArena::Alloc(size_t size)
+{
+	size = alignSize(size);
+
+	char *p;
+	if(used + size <= capacity)
+	{
+		p = base + used;
+	}
+	else
+	{
+		// Full : the block is grown by the next Reset
+		char *extra = new char[size + FRAME_ARENA_ALIGN - 1];
+		overflow.push_back(extra);
+		p = alignPointer(extra);
+	}
+
+	used += size;
+	if(used > highWater)
+		highWater = used;
+	return p;
+}
+
+void FrameArena::Rewind(size_t mark)
+{
+	if(mark < used)
+		used = mark;
+}
+
+void FrameArena::Reset(void)
+{
+	used = 0;
+	if(overflow.empty())
+		return;
+
+	for(size_t i = 0; i < overflow.size(); i++)
+		delete[] overflow[i];
+	overflow.clear();
+
+	// Double the capacity until the largest frame fits
+	size_t size = capacity ? capacity : FRAME_ARENA_ALIGN;
+	while(size < highWater)
+		size *= 2;
+	Reserve(size);
+}
+
+void FrameArena::Reserve(size_t size)
+{
+	size = alignSize(size);
+	if(size <= capacity)
+		return;
+
+	delete[] block;
+	block = new char[size + FRAME_ARENA_ALIGN - 1];
+	base = alignPointer(block);
+	capacity = size;
+}
+
+size_t FrameArena::GetCapacity(void) const
+{
+	return capacity;
+}
+
+size_t FrameArena::GetHighWaterMark(void) const
+{
+	return highWater;
+}
+
+size_t FrameArena::GetUsed(void) const
+{
+	return used;
+}
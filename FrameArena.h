@@ -0,0 +1,78 @@
+/**
+* File : FrameArena.h
+* Description : Linear allocator for the temporary buffers of a frame
+*
+* Author(s) : ALucchi
+* Date of creation : 17/10/2026
+* Modification(s) :
+*/
+
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+//-------------------------------------------------------------------- INCLUDES
+#include "defs.h"
+#include <stddef.h>
+#include <vector>
+
+//---------------------------------------------------------------------- CONSTS
+
+#define FRAME_ARENA_INITIAL_SIZE	(64*1024)
+#define FRAME_ARENA_ALIGN			16		// alignment of the allocations (SIMD loads)
+
+//--------------------------------------------------------------------- CLASSES
+
+/* Memory is allocated by moving a pointer in a single block and is released
+	all at once by Reset, at the beginning of each frame. GetMark and Rewind
+	release the allocations made after the mark, for the buffers which don't
+	live the whole frame.
+	When the block is full, the allocations are served by additional blocks
+	and Reset grows the main block to the high-water mark : once the largest
+	frame of the scene has been rendered, there is no heap allocation. */
+class FrameArena
+{
+public:
+	FrameArena(size_t size = FRAME_ARENA_INITIAL_SIZE);
+	~FrameArena();
+
+	// Uninitialized memory, aligned on FRAME_ARENA_ALIGN bytes
+	void* Alloc(size_t size);
+
+	template<class T>
+	inline T* Alloc(int num)
+	{
+		return (T*)Alloc(num * sizeof(T));
+	}
+
+	inline size_t GetMark(void) const
+	{
+		return used;
+	}
+
+	// Release the allocations made since GetMark returned mark
+	void Rewind(size_t mark);
+
+	// Release everything
+	void Reset(void);
+
+	// Grow the main block to size bytes (nothing may be allocated)
+	void Reserve(size_t size);
+
+	size_t GetCapacity(void) const;
+	size_t GetHighWaterMark(void) const;
+	size_t GetUsed(void) const;
+
+private:
+	char		*block,				// main block, as allocated
+				*base;				// aligned start of the main block
+	size_t	capacity,			// size of the main block
+				used,					// bytes allocated, including the additional blocks
+				highWater;			// maximum of used since the construction
+	std::vector<char*>	overflow;	// additional blocks, freed by Reset
+
+	// Prevent copy
+	FrameArena(const FrameArena&);
+	FrameArena& operator=(const FrameArena&);
+};
+
+#endif // FRAME_ARENA_H
@@ -0,0 +1,244 @@
+/**
+* File : fixed.h
+* Description : 3D Math library : fixed point numbers
+*
+* Author(s) : ALucchi
+* Date of creation : 17/10/2026
+* Modification(s) :
+*/
+
+#ifndef FIXED_H
+#define FIXED_H
+
+//-------------------------------------------------------------------- INCLUDES
+#include <limits>
+#include <math.h>
+#include "Vector3.h"
+#include "Matrix4x3.h"
+
+//----------------------------------------------------------------------- TYPES
+
+#if defined(_MSC_VER) && _MSC_VER < 1600
+typedef __int64				FixedWide;
+#else
+typedef long long			FixedWide;
+#endif
+typedef unsigned int			FixedUInt;
+
+//--------------------------------------------------------------------- CLASSES
+
+/* Signed fixed point number with IntBits integer bits (sign included) and
+	FracBits fractional bits, stored in 32 bits. The constructors and the
+	operators are inline, so the conversions of constants are folded by the
+	compiler.
+	Additions and subtractions wrap like integers. Products and quotients are
+	computed on 64 bits, rounded toward minus infinity and saturated to the
+	range of the type, a division by zero giving the bound of the sign of the
+	dividend. */
+template <int IntBits, int FracBits>
+class Fixed
+{
+public:
+	enum {
+		FRAC_BITS = FracBits,
+		ONE = 1 << FracBits};
+
+	int raw;
+
+	inline Fixed(void) : raw(0) {}
+	inline Fixed(int i) : raw(i * ONE) {}
+	inline Fixed(float f) : raw((int)floor(f * ONE + 0.5f)) {}
+	inline Fixed(double d) : raw((int)floor(d * ONE + 0.5)) {}
+
+	static inline Fixed FromRaw(int r)
+	{
+		Fixed f;
+		f.raw = r;
+		return f;
+	}
+
+	inline float ToFloat(void) const
+	{
+		return raw * (1.0f / ONE);
+	}
+
+	// Rounded toward minus infinity
+	inline int ToInt(void) const
+	{
+		return raw >> FracBits;
+	}
+
+	static inline Fixed Max(void)
+	{
+		return FromRaw(0x7FFFFFFF >> (32 - IntBits - FracBits));
+	}
+
+	static inline Fixed Min(void)
+	{
+		return FromRaw(-Max().raw - 1);
+	}
+
+	inline Fixed operator +() const { return *this; }
+	inline Fixed operator -() const { return FromRaw(-raw); }
+
+	inline Fixed& operator +=(Fixed f) { raw += f.raw; return *this; }
+	inline Fixed& operator -=(Fixed f) { raw -= f.raw; return *this; }
+	inline Fixed& operator *=(Fixed f) { *this = *this * f; return *this; }
+	inline Fixed& operator /=(Fixed f) { *this = *this / f; return *this; }
+
+	friend inline Fixed operator +(Fixed a, Fixed b) { return FromRaw(a.raw + b.raw); }
+	friend inline Fixed operator -(Fixed a, Fixed b) { return FromRaw(a.raw - b.raw); }
+
+	friend inline Fixed operator *(Fixed a, Fixed b)
+	{
+		return saturate(((FixedWide)a.raw * b.raw) >> FracBits);
+	}
+
+	friend inline Fixed operator /(Fixed a, Fixed b)
+	{
+		if(b.raw == 0)
+			return a.raw < 0 ? Min() : Max();
+
+		// The division truncates toward zero
+		FixedWide n = (FixedWide)a.raw << FracBits;
+		FixedWide q = n / b.raw;
+		if(q * b.raw != n && (n < 0) != (b.raw < 0))
+			q--;
+		return saturate(q);
+	}
+
+	friend inline bool operator ==(Fixed a, Fixed b) { return a.raw == b.raw; }
+	friend inline bool operator !=(Fixed a, Fixed b) { return a.raw != b.raw; }
+	friend inline bool operator <(Fixed a, Fixed b) { return a.raw < b.raw; }
+	friend inline bool operator <=(Fixed a, Fixed b) { return a.raw <= b.raw; }
+	friend inline bool operator >(Fixed a, Fixed b) { return a.raw > b.raw; }
+	friend inline bool operator >=(Fixed a, Fixed b) { return a.raw >= b.raw; }
+
+private:
+	// IntBits + FracBits must fit in the 32 bits of raw
+	typedef char checkSize[(IntBits > 0 && FracBits >= 0 && IntBits + FracBits <= 32) ? 1 : -1];
+
+	static inline Fixed saturate(FixedWide r)
+	{
+		if(r > Max().raw)
+			return Max();
+		if(r < Min().raw)
+			return Min();
+		return FromRaw((int)r);
+	}
+};
+
+typedef Fixed<16, 16> Fixed16;		// same format as the texture coordinates
+
+/* Affine matrix of any number type : the Mat4x3 of the fixed point
+	pipeline */
+template <class T>
+class CMat4x3
+{
+public:
+	T _11, _12, _13,
+	  _21, _22, _23,
+	  _31, _32, _33,
+	  _41, _42, _43;
+
+	CMat4x3(void)
+	{
+		_11 = 1; _12 = 0; _13 = 0;
+		_21 = 0; _22 = 1; _23 = 0;
+		_31 = 0; _32 = 0; _33 = 1;
+		_41 = 0; _42 = 0; _43 = 0;
+	}
+
+	// Conversion of a float matrix
+	explicit CMat4x3(const Mat4x3& mat)
+	{
+		_11 = T(mat._11); _12 = T(mat._12); _13 = T(mat._13);
+		_21 = T(mat._21); _22 = T(mat._22); _23 = T(mat._23);
+		_31 = T(mat._31); _32 = T(mat._32); _33 = T(mat._33);
+		_41 = T(mat._41); _42 = T(mat._42); _43 = T(mat._43);
+	}
+};
+
+typedef CVector3<Fixed16>	Vector3x;
+typedef CMat4x3<Fixed16>	Mat4x3x;
+
+//------------------------------------------------------------------- FUNCTIONS
+
+/* Square root of n rounded down, one bit of the root per iteration : no
+	float, no division */
+inline FixedUInt SqrtWide(FixedWide n)
+{
+	FixedWide root = 0, bit = (FixedWide)1 << 62;
+	while(bit > n)
+		bit >>= 2;
+
+	while(bit)
+	{
+		if(n >= root + bit)
+		{
+			n -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else
+			root >>= 1;
+		bit >>= 2;
+	}
+	return (FixedUInt)root;
+}
+
+// Overloads used by CVector3 (Length, Normalize). sqrtf of a negative number is 0
+template <int I, int F>
+inline Fixed<I, F> sqrtf(Fixed<I, F> f)
+{
+	if(f.raw <= 0)
+		return Fixed<I, F>();
+	return Fixed<I, F>::FromRaw((int)SqrtWide((FixedWide)f.raw << F));
+}
+
+template <int I, int F>
+inline Fixed<I, F> fabs(Fixed<I, F> f)
+{
+	return f.raw < 0 ? -f : f;
+}
+
+template <class T>
+inline CVector3<T> operator*(const CVector3<T>& vec, const CMat4x3<T>& mat)
+{
+	return CVector3<T>(vec.x * mat._11 + vec.y * mat._21 + vec.z * mat._31 + mat._41,
+							 vec.x * mat._12 + vec.y * mat._22 + vec.z * mat._32 + mat._42,
+							 vec.x * mat._13 + vec.y * mat._23 + vec.z * mat._33 + mat._43);
+}
+
+template <class T>
+inline CMat4x3<T> operator*(const CMat4x3<T>& m1, const CMat4x3<T>& m2)
+{
+	CMat4x3<T> mat;
+	mat._11 = m1._11 * m2._11 + m1._12 * m2._21 + m1._13 * m2._31;
+	mat._12 = m1._11 * m2._12 + m1._12 * m2._22 + m1._13 * m2._32;
+	mat._13 = m1._11 * m2._13 + m1._12 * m2._23 + m1._13 * m2._33;
+	mat._21 = m1._21 * m2._11 + m1._22 * m2._21 + m1._23 * m2._31;
+	mat._22 = m1._21 * m2._12 + m1._22 * m2._22 + m1._23 * m2._32;
+	mat._23 = m1._21 * m2._13 + m1._22 * m2._23 + m1._23 * m2._33;
+	mat._31 = m1._31 * m2._11 + m1._32 * m2._21 + m1._33 * m2._31;
+	mat._32 = m1._31 * m2._12 + m1._32 * m2._22 + m1._33 * m2._32;
+	mat._33 = m1._31 * m2._13 + m1._32 * m2._23 + m1._33 * m2._33;
+	mat._41 = m1._41 * m2._11 + m1._42 * m2._21 + m1._43 * m2._31 + m2._41;
+	mat._42 = m1._41 * m2._12 + m1._42 * m2._22 + m1._43 * m2._32 + m2._42;
+	mat._43 = m1._41 * m2._13 + m1._42 * m2._23 + m1._43 * m2._33 + m2._43;
+	return mat;
+}
+
+namespace std
+{
+	// epsilon is used by CVector3::Normalize
+	template <int I, int F>
+	class numeric_limits< Fixed<I, F> > : public numeric_limits<int>
+	{
+	public:
+		static Fixed<I, F> epsilon() throw() { return Fixed<I, F>::FromRaw(1); }
+		static Fixed<I, F> min() throw() { return Fixed<I, F>::Min(); }
+		static Fixed<I, F> max() throw() { return Fixed<I, F>::Max(); }
+	};
+}
+
+#endif // FIXED_H
@@ -9,6 +9,17 @@
 
 #include "Matrix4.h"
 #include "math3D.h"
+#include <time.h>
+
+#ifdef MATRIX_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef MATRIX_AVX2
+#include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 Mat4x4::Mat4x4(void) {
 	identity();
@@ -73,32 +84,24 @@ void Mat4x4::translate(float tx, float ty, float tz) {
 void Mat4x4::rotate(float rx, float ry, float rz) {
 	Mat4x4 temp(*this), rotX, rotY, rotZ;
 	
-	long x = (long)rx;	
-	long y = (long)ry;
-	long z = (long)rz;
-	
-	x = x % 360;
-	y = y % 360;
-	z = z % 360;
-
-	if(x < 0) x += 360;
-	if(y < 0) y += 360;
-	if(z < 0) z += 360;
+	Angle x = degToAngle(rx);
+	Angle y = degToAngle(ry);
+	Angle z = degToAngle(rz);
 
-	rotX._22 = COS(x);
-	rotX._23 = SIN(x);
-	rotX._32 = -SIN(x);
-	rotX._33 = COS(x);
+	rotX._22 = angleCos(x);
+	rotX._23 = angleSin(x);
+	rotX._32 = -angleSin(x);
+	rotX._33 = angleCos(x);
 
-	rotY._11 = COS(y);
-	rotY._13 = -SIN(y);
-	rotY._31 = SIN(y);
-	rotY._33 = COS(y);
+	rotY._11 = angleCos(y);
+	rotY._13 = -angleSin(y);
+	rotY._31 = angleSin(y);
+	rotY._33 = angleCos(y);
 
-	rotZ._11 = COS(z);
-	rotZ._12 = SIN(z);
-	rotZ._21 = -SIN(z);
-	rotZ._22 = COS(z);
+	rotZ._11 = angleCos(z);
+	rotZ._12 = angleSin(z);
+	rotZ._21 = -angleSin(z);
+	rotZ._22 = angleCos(z);
 
 	*this = rotX * temp;
 	temp = rotY * *this;
@@ -296,4 +299,218 @@ Mat4x4 operator*(const Mat4x4& mat, float s) {
 
 Mat4x4 operator*(float s, const Mat4x4& mat) {
 	return (mat * s);
-}
\ No newline at end of file
+}
+
+//------------------------------------------------------------ BATCH TRANSFORMS
+
+/* The coefficients of the columns are passed as c[12] = {_11, _21, _31, _41,
+	_12, ...}, the translation being 0 for the normals. The SIMD kernels do the
+	same operations in the same order as the scalar one, so the results are
+	identical. */
+typedef void (*TransformKernel)(const float *c, const float *x, const float *y, const float *z,
+										  float *ox, float *oy, float *oz, int num);
+
+static void transformScalar(const float *c, const float *x, const float *y, const float *z,
+									 float *ox, float *oy, float *oz, int num)
+{
+	for(int i = 0; i < num; i++)
+	{
+		float px = x[i], py = y[i], pz = z[i];
+		ox[i] = px * c[0] + py * c[1] + pz * c[2] + c[3];
+		oy[i] = px * c[4] + py * c[5] + pz * c[6] + c[7];
+		oz[i] = px * c[8] + py * c[9] + pz * c[10] + c[11];
+	}
+}
+
+#ifdef MATRIX_SSE2
+static void transformSSE2(const float *c, const float *x, const float *y, const float *z,
+								  float *ox, float *oy, float *oz, int num)
+{
+	__m128 k[12];
+	for(int j = 0; j < 12; j++)
+		k[j] = _mm_set1_ps(c[j]);
+
+	int i = 0;
+	for(; i + 4 <= num; i += 4)
+	{
+		__m128 px = _mm_loadu_ps(x + i);
+		__m128 py = _mm_loadu_ps(y + i);
+		__m128 pz = _mm_loadu_ps(z + i);
+		__m128 rx = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, k[0]), _mm_mul_ps(py, k[1])), _mm_mul_ps(pz, k[2])), k[3]);
+		__m128 ry = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, k[4]), _mm_mul_ps(py, k[5])), _mm_mul_ps(pz, k[6])), k[7]);
+		__m128 rz = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, k[8]), _mm_mul_ps(py, k[9])), _mm_mul_ps(pz, k[10])), k[11]);
+		_mm_storeu_ps(ox + i, rx);
+		_mm_storeu_ps(oy + i, ry);
+		_mm_storeu_ps(oz + i, rz);
+	}
+
+	transformScalar(c, x + i, y + i, z + i, ox + i, oy + i, oz + i, num - i);
+}
+#endif //MATRIX_SSE2
+
+#ifdef MATRIX_AVX2
+MATRIX_AVX2_TARGET
+static void transformAVX2(const float *c, const float *x, const float *y, const float *z,
+								  float *ox, float *oy, float *oz, int num)
+{
+	__m256 k[12];
+	for(int j = 0; j < 12; j++)
+		k[j] = _mm256_set1_ps(c[j]);
+
+	// No FMA : the products are rounded like the scalar ones
+	int i = 0;
+	for(; i + 8 <= num; i += 8)
+	{
+		__m256 px = _mm256_loadu_ps(x + i);
+		__m256 py = _mm256_loadu_ps(y + i);
+		__m256 pz = _mm256_loadu_ps(z + i);
+		__m256 rx = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px, k[0]), _mm256_mul_ps(py, k[1])), _mm256_mul_ps(pz, k[2])), k[3]);
+		__m256 ry = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px, k[4]), _mm256_mul_ps(py, k[5])), _mm256_mul_ps(pz, k[6])), k[7]);
+		__m256 rz = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px, k[8]), _mm256_mul_ps(py, k[9])), _mm256_mul_ps(pz, k[10])), k[11]);
+		_mm256_storeu_ps(ox + i, rx);
+		_mm256_storeu_ps(oy + i, ry);
+		_mm256_storeu_ps(oz + i, rz);
+	}
+
+	transformScalar(c, x + i, y + i, z + i, ox + i, oy + i, oz + i, num - i);
+}
+#endif //MATRIX_AVX2
+
+static TransformKernel getTransformKernel(int isa)
+{
+	switch(isa)
+	{
+#ifdef MATRIX_AVX2
+		case Mat4x4::AVX2:	return transformAVX2;
+#endif
+#ifdef MATRIX_SSE2
+		case Mat4x4::SSE2:	return transformSSE2;
+#endif
+		default:				return transformScalar;
+	}
+}
+
+static int transformISA = -1;
+static TransformKernel transformKernel = NULL;
+
+static inline TransformKernel currentTransformKernel(void)
+{
+	if(!transformKernel)
+		Mat4x4::setISA(Mat4x4::getBestISA());
+	return transformKernel;
+}
+
+void Mat4x4::transformPoints(const float *x, const float *y, const float *z,
+									  float *ox, float *oy, float *oz, int num) const {
+	float c[12] = {_11, _21, _31, _41,
+						_12, _22, _32, _42,
+						_13, _23, _33, _43};
+	currentTransformKernel()(c, x, y, z, ox, oy, oz, num);
+}
+
+void Mat4x4::transformNormals(const float *x, const float *y, const float *z,
+										float *ox, float *oy, float *oz, int num) const {
+	float c[12] = {_11, _21, _31, 0,
+						_12, _22, _32, 0,
+						_13, _23, _33, 0};
+	currentTransformKernel()(c, x, y, z, ox, oy, oz, num);
+}
+
+void Mat4x4::setISA(int isa) {
+	int best = getBestISA();
+	transformISA = isa < SCALAR ? SCALAR : isa > best ? best : isa;
+	transformKernel = getTransformKernel(transformISA);
+}
+
+int Mat4x4::getISA(void) {
+	currentTransformKernel();
+	return transformISA;
+}
+
+int Mat4x4::getBestISA(void) {
+#if defined(MATRIX_AVX2) && defined(__GNUC__)
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2"))
+		return AVX2;
+#elif defined(MATRIX_AVX2) && defined(_MSC_VER)
+	// AVX2 needs the CPU flag and the OS saving the ymm registers
+	int info[4];
+	__cpuid(info, 1);
+	if((info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6)
+	{
+		__cpuidex(info, 7, 0);
+		if(info[1] & (1 << 5))
+			return AVX2;
+	}
+#endif
+
+#ifdef MATRIX_SSE2
+	return SSE2;
+#else
+	return SCALAR;
+#endif
+}
+
+const char* Mat4x4::getISAName(int isa) {
+	switch(isa)
+	{
+		case SCALAR:	return "scalar";
+		case SSE2:		return "sse2";
+		case AVX2:		return "avx2";
+		default:			return "unknown";
+	}
+}
+
+/* Transform 4096 points (48 KB in, 48 KB out : in the L2 cache) during a
+	quarter of second for each instruction set. The number of points is not
+	a multiple of 8, so the scalar tail of the kernels is checked too. */
+void Mat4x4::benchmark(void) {
+	const int num = 4093;
+
+	float *in = new float[num * 3];
+	float *ref = new float[num * 3];
+	float *out = new float[num * 3];
+	for(int i = 0; i < num * 3; i++)
+		in[i] = (float)((i * 7919) % 2000 - 1000) / 100.0f;
+
+	Mat4x4 mat;
+	mat.rotate(30, 45, 60);
+	mat.translate(1.5f, -2.0f, 10.0f);
+
+	float c[12] = {mat._11, mat._21, mat._31, mat._41,
+						mat._12, mat._22, mat._32, mat._42,
+						mat._13, mat._23, mat._33, mat._43};
+	transformScalar(c, in, in + num, in + 2*num, ref, ref + num, ref + 2*num, num);
+
+	for(int isa = SCALAR; isa <= getBestISA(); isa++)
+	{
+		TransformKernel kernel = getTransformKernel(isa);
+
+		kernel(c, in, in + num, in + 2*num, out, out + num, out + 2*num, num);
+		float error = 0;
+		for(int i = 0; i < num * 3; i++)
+		{
+			float d = (float)fabs(out[i] - ref[i]);
+			if(d > error)
+				error = d;
+		}
+
+		long points = 0;
+		clock_t start = clock(), end;
+		do
+		{
+			for(int n = 0; n < 64; n++)
+				kernel(c, in, in + num, in + 2*num, out, out + num, out + 2*num, num);
+			points += 64 * num;
+			end = clock();
+		} while(end - start < CLOCKS_PER_SEC / 4);
+
+		double seconds = (double)(end - start) / CLOCKS_PER_SEC;
+		printf("Batch transform %-6s : %8.1f Mpoints/s, max error %g\n", getISAName(isa),
+				 (double)points / seconds / 1000000.0, error);
+	}
+
+	delete[] in;
+	delete[] ref;
+	delete[] out;
+}
@@ -13,10 +13,31 @@
 //--------------------------------------------------------------------- INCLUDE
 #include <stdio.h>
 
+//---------------------------------------------------------------------- CONSTS
+
+// SIMD batch transforms are compiled on x86 only
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define MATRIX_SSE2
+	#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+		#define MATRIX_AVX2
+		#define MATRIX_AVX2_TARGET	__attribute__((target("avx2")))
+	#elif defined(_MSC_VER) && _MSC_VER >= 1700
+		#define MATRIX_AVX2
+		#define MATRIX_AVX2_TARGET
+	#endif
+#endif
+
 class Mat4x4 {
 
 public:
 
+	// Instruction sets of the batch transforms
+	enum ISA {
+		SCALAR,
+		SSE2,
+		AVX2,
+		NUM_ISAS};
+
 	union {
 		struct {
 			float _11, _12, _13, _14,
@@ -57,6 +78,26 @@ public:
 	friend Mat4x4 operator*(const Mat4x4& mat, float s);
 	friend Mat4x4 operator*(float s, const Mat4x4& mat);
 
+	/* Batch transforms of num vectors stored as one array per component
+		(VertexArrays) : (ox,oy,oz) = (x,y,z) * mat. The output arrays may be
+		the input arrays. Same results as operator*(Vector3, Mat4x4). */
+	void transformPoints(const float *x, const float *y, const float *z,
+								float *ox, float *oy, float *oz, int num) const;
+
+	// Same without the translation, for the normals
+	void transformNormals(const float *x, const float *y, const float *z,
+								 float *ox, float *oy, float *oz, int num) const;
+
+	// isa is lowered to the best instruction set supported
+	static void setISA(int isa);
+	static int getISA(void);
+	static int getBestISA(void);
+	static const char* getISAName(int isa);
+
+	/* Print the throughput of the batch transforms for each instruction set
+		and their largest difference with the scalar transform */
+	static void benchmark(void);
+
 	inline void output(void) {
 		printf("%f %f %f %f\n"
 			   "%f %f %f %f\n"
@@ -0,0 +1,203 @@
+/**
+* File : matrix4x3.cpp
+* Description : 3D Math library : affine matrix routines
+*				  
+* Author(s) : ALucchi
+* Date of creation : 17/10/2026
+* Modification(s) :
+*/
+
+#include "Matrix4x3.h"
+#include "math3D.h"
+#include <time.h>
+
+Mat4x3::Mat4x3(void) {
+	identity();
+}
+
+Mat4x3::Mat4x3(const Mat4x4& mat) {
+	_11 = mat._11; _12 = mat._12; _13 = mat._13;
+	_21 = mat._21; _22 = mat._22; _23 = mat._23;
+	_31 = mat._31; _32 = mat._32; _33 = mat._33;
+	_41 = mat._41; _42 = mat._42; _43 = mat._43;
+}
+
+void Mat4x3::identity(void) {
+	_11 = 1; _12 = 0; _13 = 0;
+	_21 = 0; _22 = 1; _23 = 0;
+	_31 = 0; _32 = 0; _33 = 1;
+	_41 = 0; _42 = 0; _43 = 0;
+}
+
+// Scale matrix * this : scales the rows of the linear part
+void Mat4x3::scale(float sx, float sy, float sz) {
+	_11 *= sx; _12 *= sx; _13 *= sx;
+	_21 *= sy; _22 *= sy; _23 *= sy;
+	_31 *= sz; _32 *= sz; _33 *= sz;
+}
+
+// Translation matrix * this : only the translation changes
+void Mat4x3::translate(float tx, float ty, float tz) {
+	_41 = tx * _11 + ty * _21 + tz * _31 + _41;
+	_42 = tx * _12 + ty * _22 + tz * _32 + _42;
+	_43 = tx * _13 + ty * _23 + tz * _33 + _43;
+}
+
+/* rotZ * rotY * rotX * this. Each rotation only mixes two rows of the
+	linear part. */
+void Mat4x3::rotate(float rx, float ry, float rz) {
+	Angle x = degToAngle(rx);
+	Angle y = degToAngle(ry);
+	Angle z = degToAngle(rz);
+
+	float c, s, a, b;
+
+	// Rows 2 and 3
+	c = angleCos(x); s = angleSin(x);
+	a = _21; b = _31; _21 = c * a + s * b; _31 = c * b - s * a;
+	a = _22; b = _32; _22 = c * a + s * b; _32 = c * b - s * a;
+	a = _23; b = _33; _23 = c * a + s * b; _33 = c * b - s * a;
+
+	// Rows 1 and 3
+	c = angleCos(y); s = angleSin(y);
+	a = _11; b = _31; _11 = c * a - s * b; _31 = s * a + c * b;
+	a = _12; b = _32; _12 = c * a - s * b; _32 = s * a + c * b;
+	a = _13; b = _33; _13 = c * a - s * b; _33 = s * a + c * b;
+
+	// Rows 1 and 2
+	c = angleCos(z); s = angleSin(z);
+	a = _11; b = _21; _11 = c * a + s * b; _21 = c * b - s * a;
+	a = _12; b = _22; _12 = c * a + s * b; _22 = c * b - s * a;
+	a = _13; b = _23; _13 = c * a + s * b; _23 = c * b - s * a;
+}
+
+Mat4x3 Mat4x3::inverse(void) const {
+	Mat4x3 inv;
+
+	// Inverse of the linear part : cofactors / determinant
+	inv._11 = _22 * _33 - _23 * _32;
+	inv._12 = _13 * _32 - _12 * _33;
+	inv._13 = _12 * _23 - _13 * _22;
+	inv._21 = _23 * _31 - _21 * _33;
+	inv._22 = _11 * _33 - _13 * _31;
+	inv._23 = _13 * _21 - _11 * _23;
+	inv._31 = _21 * _32 - _22 * _31;
+	inv._32 = _12 * _31 - _11 * _32;
+	inv._33 = _11 * _22 - _12 * _21;
+
+	float det = 1.0f / (_11 * inv._11 + _12 * inv._21 + _13 * inv._31);
+	inv._11 *= det; inv._12 *= det; inv._13 *= det;
+	inv._21 *= det; inv._22 *= det; inv._23 *= det;
+	inv._31 *= det; inv._32 *= det; inv._33 *= det;
+
+	// The translation is undone before the linear part
+	inv._41 = -(_41 * inv._11 + _42 * inv._21 + _43 * inv._31);
+	inv._42 = -(_41 * inv._12 + _42 * inv._22 + _43 * inv._32);
+	inv._43 = -(_41 * inv._13 + _42 * inv._23 + _43 * inv._33);
+
+	return inv;
+}
+
+Mat4x4 Mat4x3::toMat4x4(void) const {
+	return Mat4x4(_11, _12, _13, 0,
+				  _21, _22, _23, 0,
+				  _31, _32, _33, 0,
+				  _41, _42, _43, 1);
+}
+
+Mat4x3& Mat4x3::operator*=(const Mat4x3& mat) {
+	*this = *this * mat;
+	return *this;
+}
+
+// 36 multiplications and 27 additions, instead of 64 and 48
+Mat4x3 operator*(const Mat4x3& m1, const Mat4x3& m2) {
+	Mat4x3 mat;
+	float a, b, c;
+
+	a=m1._11,b=m1._12,c=m1._13;
+	mat._11 = a * m2._11 + b * m2._21 + c * m2._31;
+	mat._12 = a * m2._12 + b * m2._22 + c * m2._32;
+	mat._13 = a * m2._13 + b * m2._23 + c * m2._33;
+
+	a=m1._21,b=m1._22,c=m1._23;
+	mat._21 = a * m2._11 + b * m2._21 + c * m2._31;
+	mat._22 = a * m2._12 + b * m2._22 + c * m2._32;
+	mat._23 = a * m2._13 + b * m2._23 + c * m2._33;
+
+	a=m1._31,b=m1._32,c=m1._33;
+	mat._31 = a * m2._11 + b * m2._21 + c * m2._31;
+	mat._32 = a * m2._12 + b * m2._22 + c * m2._32;
+	mat._33 = a * m2._13 + b * m2._23 + c * m2._33;
+
+	a=m1._41,b=m1._42,c=m1._43;
+	mat._41 = a * m2._11 + b * m2._21 + c * m2._31 + m2._41;
+	mat._42 = a * m2._12 + b * m2._22 + c * m2._32 + m2._42;
+	mat._43 = a * m2._13 + b * m2._23 + c * m2._33 + m2._43;
+
+	return mat;
+}
+
+void Mat4x3::transformPoints(const float *x, const float *y, const float *z,
+									  float *ox, float *oy, float *oz, int num) const {
+	toMat4x4().transformPoints(x, y, z, ox, oy, oz, num);
+}
+
+void Mat4x3::transformNormals(const float *x, const float *y, const float *z,
+										float *ox, float *oy, float *oz, int num) const {
+	toMat4x4().transformNormals(x, y, z, ox, oy, oz, num);
+}
+
+/* Build the world matrix of an object, as Renderer::Identity, Translate and
+	Rotate do each frame. Per matrix, the Mat4x4 does 4 full products (256
+	multiplications, 192 additions) with 6 temporary matrices, the Mat4x3
+	does 45 multiplications and 27 additions in place. */
+void Mat4x3::benchmark(void) {
+	const int num = 100000;
+	float sum4 = 0, sum3 = 0, error = 0;
+
+	clock_t start = clock();
+	for(int i = 0; i < num; i++)
+	{
+		Mat4x4 mat;
+		mat.identity();
+		mat.translate((float)(i & 15), 1.0f, 10.0f);
+		mat.rotate((float)i, (float)(i * 2), (float)(i * 3));
+		sum4 += mat._41 + mat._11;
+	}
+	clock_t mid = clock();
+	for(int i = 0; i < num; i++)
+	{
+		Mat4x3 mat;
+		mat.identity();
+		mat.translate((float)(i & 15), 1.0f, 10.0f);
+		mat.rotate((float)i, (float)(i * 2), (float)(i * 3));
+		sum3 += mat._41 + mat._11;
+	}
+	clock_t end = clock();
+
+	// Both must give the same matrices
+	for(int i = 0; i < 360; i++)
+	{
+		Mat4x4 m4;
+		m4.translate(1.0f, 2.0f, 3.0f);
+		m4.rotate((float)i, (float)(i * 2), (float)(i * 3));
+		Mat4x3 m3;
+		m3.translate(1.0f, 2.0f, 3.0f);
+		m3.rotate((float)i, (float)(i * 2), (float)(i * 3));
+		Mat4x3 d(m4);
+		const float *p = &d._11, *q = &m3._11;
+		for(int k = 0; k < 12; k++)
+			if(fabs(p[k] - q[k]) > error)
+				error = (float)fabs(p[k] - q[k]);
+	}
+
+	printf("World matrix Mat4x4 : %6.1f ns (256 mul, 192 add, 6 temporaries)\n",
+			 (double)(mid - start) / CLOCKS_PER_SEC * 1e9 / num);
+	printf("World matrix Mat4x3 : %6.1f ns (45 mul, 27 add, in place), max difference %g\n",
+			 (double)(end - mid) / CLOCKS_PER_SEC * 1e9 / num, error);
+
+	// Keep the loops
+	if(sum4 + sum3 == 1234.5f)
+		printf("\n");
+}
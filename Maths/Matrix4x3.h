@@ -0,0 +1,58 @@
+/**
+* File : matrix4x3.h
+* Description : 3D Math library : affine matrix routines
+*				  
+* Author(s) : ALucchi
+* Date of creation : 17/10/2026
+* Modification(s) :
+*/
+
+#ifndef MATRIX4X3_H
+#define MATRIX4X3_H
+
+//--------------------------------------------------------------------- INCLUDE
+#include "Matrix4.h"
+
+/* Affine transform : a Mat4x4 whose last column is (0,0,0,1), which is not
+	stored. Rows 1 to 3 are the linear part, row 4 the translation. The
+	products skip the constant column and the transforms are done in place,
+	without temporary matrices. */
+class Mat4x3 {
+
+public:
+
+	float _11, _12, _13,
+		  _21, _22, _23,
+		  _31, _32, _33,
+		  _41, _42, _43;
+
+	Mat4x3(void);
+	explicit Mat4x3(const Mat4x4& mat);	// the last column of mat is ignored
+
+	void identity(void);
+
+	// Same as the Mat4x4 functions : the transform is applied first
+	void scale(float sx, float sy, float sz);
+	void translate(float tx, float ty, float tz);
+	void rotate(float rx, float ry, float rz);
+
+	// The linear part must be invertible
+	Mat4x3 inverse(void) const;
+
+	Mat4x4 toMat4x4(void) const;
+
+	Mat4x3& operator*=(const Mat4x3& mat);
+	friend Mat4x3 operator*(const Mat4x3& m1, const Mat4x3& m2);
+
+	// See Mat4x4::transformPoints
+	void transformPoints(const float *x, const float *y, const float *z,
+								float *ox, float *oy, float *oz, int num) const;
+	void transformNormals(const float *x, const float *y, const float *z,
+								 float *ox, float *oy, float *oz, int num) const;
+
+	/* Print the time taken to build a world matrix (identity, translate,
+		rotate) with a Mat4x4 and with a Mat4x3 */
+	static void benchmark(void);
+};
+
+#endif //MATRIX4X3_H
@@ -0,0 +1,27 @@
+/**
+* File : trig.cpp
+* Description : 3D Math library : sine and cosine of binary angles
+*
+* Author(s) : ALucchi
+* Date of creation : 17/10/2026
+* Modification(s) :
+*/
+
+//-------------------------------------------------------------------- INCLUDES
+#include <math.h>
+#include "Trig.h"
+
+//------------------------------------------------------------------- VARIABLES
+TrigLuts trigLuts;
+
+//------------------------------------------------------------------- FUNCTIONS
+
+void trigInit(void)
+{
+	for(int i = 0; i < TRIG_TABLE_SIZE; i++)
+	{
+		double s = sin(i * 6.283185307179586 / TRIG_LUT_SIZE);
+		trigLuts.sin[i] = (float)s;
+		trigLuts.sinFixed[i] = (long)floor(s * 65536.0 + 0.5);
+	}
+}
@@ -0,0 +1,91 @@
+/**
+* File : trig.h
+* Description : 3D Math library : sine and cosine of binary angles
+*
+* Author(s) : ALucchi
+* Date of creation : 17/10/2026
+* Modification(s) :
+*/
+
+#ifndef TRIG_H
+#define TRIG_H
+
+//---------------------------------------------------------------------- CONSTS
+
+/* A turn is 65536 binary angle steps : the angles wrap with the integer
+	type, without modulo. The high bits index the tables, the low bits
+	interpolate between two entries. */
+#define ANGLE_BITS			16
+#define TRIG_LUT_BITS		10
+#define TRIG_LUT_SIZE		(1 << TRIG_LUT_BITS)			// entries per turn
+#define TRIG_FRAC_BITS		(ANGLE_BITS - TRIG_LUT_BITS)
+#define TRIG_FRAC_MASK		((1 << TRIG_FRAC_BITS) - 1)
+
+// The cosine reads the sine a quarter of turn further, +1 for the interpolation
+#define TRIG_TABLE_SIZE		(TRIG_LUT_SIZE + TRIG_LUT_SIZE / 4 + 1)
+
+#define ANGLE_PER_DEGREE	(65536.0f / 360.0f)
+#define ANGLE_PER_RADIAN	(65536.0f / 6.283185307179586f)
+
+//----------------------------------------------------------------------- TYPES
+
+typedef unsigned short Angle;		// binary angle, 65536 per turn
+
+typedef struct {
+	float	sin[TRIG_TABLE_SIZE];
+	long	sinFixed[TRIG_TABLE_SIZE];	// 16.16 fixed point
+} TrigLuts;
+
+//------------------------------------------------------------------- VARIABLES
+extern TrigLuts trigLuts;
+
+//------------------------------------------------------------------- FUNCTIONS
+
+// Fill the tables (done by mathInit)
+void trigInit(void);
+
+// The conversions wrap any angle, negative or greater than a turn
+inline Angle degToAngle(float deg)
+{
+	return (Angle)(long)(deg * ANGLE_PER_DEGREE);
+}
+
+inline Angle radToAngle(float rad)
+{
+	return (Angle)(long)(rad * ANGLE_PER_RADIAN);
+}
+
+// Interpolation between the entries index and index+1 of the sine table
+inline float trigLerp(int index, int frac)
+{
+	float s0 = trigLuts.sin[index];
+	return s0 + (trigLuts.sin[index + 1] - s0) * (float)frac * (1.0f / (1 << TRIG_FRAC_BITS));
+}
+
+inline long trigLerpFixed(int index, int frac)
+{
+	long s0 = trigLuts.sinFixed[index];
+	return s0 + (((trigLuts.sinFixed[index + 1] - s0) * frac) >> TRIG_FRAC_BITS);
+}
+
+inline float angleSin(Angle a)
+{
+	return trigLerp(a >> TRIG_FRAC_BITS, a & TRIG_FRAC_MASK);
+}
+
+inline float angleCos(Angle a)
+{
+	return trigLerp((a >> TRIG_FRAC_BITS) + TRIG_LUT_SIZE / 4, a & TRIG_FRAC_MASK);
+}
+
+inline long angleSinFixed(Angle a)
+{
+	return trigLerpFixed(a >> TRIG_FRAC_BITS, a & TRIG_FRAC_MASK);
+}
+
+inline long angleCosFixed(Angle a)
+{
+	return trigLerpFixed((a >> TRIG_FRAC_BITS) + TRIG_LUT_SIZE / 4, a & TRIG_FRAC_MASK);
+}
+
+#endif // TRIG_H
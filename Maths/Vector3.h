@@ -14,6 +14,7 @@
 #include <limits>
 #include <iostream>
 #include "Matrix4.h"
+#include "Matrix4x3.h"
 
 //--------------------------------------------------------------------- CLASSES
 
@@ -76,6 +77,7 @@ template <class T> std::ostream& operator <<(std::ostream& Stream, const CVector
  */
 template <class T> CVector3<T> operator*(const CVector3<T>& vec, const Mat4x4& mat);
 template <class T> CVector3<T> operator*(const Mat4x4& mat, const CVector3<T>& vec);
+template <class T> CVector3<T> operator*(const CVector3<T>& vec, const Mat4x3& mat);
 
 //----------------------------------------------------------------------- TYPES
 typedef CVector3<int>   Vector3i;
@@ -218,6 +218,14 @@ CVector3<T> operator*(const Mat4x4& mat, const CVector3<T>& vec) {
 				vec.x * mat._13 + vec.y * mat._23 + vec.z * mat._33 + mat._43);
 }
 
+template <class T>
+CVector3<T> operator*(const CVector3<T>& vec, const Mat4x3& mat)
+{
+	return Vector3(vec.x * mat._11 + vec.y * mat._21 + vec.z * mat._31 + mat._41,
+				vec.x * mat._12 + vec.y * mat._22 + vec.z * mat._32 + mat._42,
+				vec.x * mat._13 + vec.y * mat._23 + vec.z * mat._33 + mat._43);
+}
+
 template <class T>
 CVector3<T>& CVector3<T>::operator*=(const Mat4x4& mat) {
 	*this = *this * mat;
@@ -10,26 +10,14 @@
 //-------------------------------------------------------------------- INCLUDES
 #include "math3D.h"
 
-//------------------------------------------------------------------- VARIABLES
-MathLuts *mathLuts = NULL;
-
 //------------------------------------------------------------------- FUNCTIONS
 
 void mathInit(void)
 {
-	double val = 0;
-	mathLuts = new MathLuts;
-	for(int i = 0; i < 360; i++, val += RAD)
-	{
-		mathLuts->sin[i] = (float)sin(val);
-		mathLuts->cos[i] = (float)cos(val);
-	}
+	trigInit();
 }
 
+// The tables are static
 void mathDeinit(void)
 {
-	if(mathLuts) {
-		delete mathLuts;
-		mathLuts = NULL;
-	}
 }
\ No newline at end of file
@@ -17,6 +17,9 @@
 #include "Vector2.h"
 #include "Vector3.h"
 #include "Matrix4.h"
+#include "Matrix4x3.h"
+#include "Trig.h"
+#include "Fixed.h"
 
 //---------------------------------------------------------------------- CONSTS
 #define FLT_ERROR	0.0001
@@ -24,24 +27,10 @@
 #define RAD			0.017453292519943
 #define DEG			57.2957795130824
 
-//---------------------------------------------------------------------- MACROS
-#define SIN(x)		(mathLuts->sin[x])
-#define COS(x)		(mathLuts->cos[x])
-
-//----------------------------------------------------------------------- TYPES
-
-typedef struct {
-	float	sin[360],
-			cos[360];
-} MathLuts;
-
 //--------------------------------------------------------------------- CLASSES
 
 //------------------------------------------------------------------- FUNCTIONS
 void mathInit(void);
 void mathDeinit(void);
 
-//------------------------------------------------------------------- VARIABLES
-extern MathLuts *mathLuts;
-
 #endif // MATH3D_H
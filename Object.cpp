@@ -13,16 +13,282 @@
 #include "Maths/math3D.h"
 #include "Object.h"
 #include "TextureManager.h"
+#include "XmlReader.h"
+#include <stdlib.h>
+#include <time.h>
 
 //---------------------------------------------------------------------- CONSTS
 
+// The benchmark meshes are written in the temporary directory
+#define BENCHMARK_MESH_FILE	"lib3d_benchmark.mesh.xml"
+#ifdef WIN32
+#define TEMP_DIRECTORY_ENV	"TEMP"
+#define TEMP_DIRECTORY		"."
+#else
+#define TEMP_DIRECTORY_ENV	"TMPDIR"
+#define TEMP_DIRECTORY		"/tmp"
+#endif
+
+//------------------------------------------------------------------- FUNCTIONS
+
+// Create the texture of the material of a submesh
+static int addMaterialTexture(const char *mat)
+{
+	char* materialName;
+
+#ifdef TRIM_MATERIAL_NAME
+	// Search for the last occurence of the directory delimiter
+	const char* posDel = strrchr(mat,'/');
+	if(posDel)
+	{
+		materialName = new char[strlen(mat)-(posDel-mat)];
+		strcpy(materialName,posDel+1);
+	}
+	else
+#endif //TRIM_MATERIAL_NAME
+	{
+		materialName = new char[strlen(mat)+1];
+		strcpy(materialName,mat);
+	}
+
+	return TextureManager::Instance().AddTexture(materialName);
+}
+
+static float attributeFloat(const XmlAttribute *attributes, int num, const char *name)
+{
+	const char *value = XmlFindAttribute(attributes, num, name);
+	return value ? parseFloat(value) : 0;
+}
+
+static int attributeInt(const XmlAttribute *attributes, int num, const char *name)
+{
+	const char *value = XmlFindAttribute(attributes, num, name);
+	return value ? parseInt(value) : 0;
+}
+
+/* Grow array, which holds used elements, to at least needed elements. The
+	capacity is at least doubled, unless the array is empty : a mesh with one
+	submesh is allocated at its exact size. */
+template <class T>
+static T* growArray(T *array, int used, int *capacity, int needed)
+{
+	if(needed <= *capacity)
+		return array;
+
+	int newCapacity = *capacity ? MAX(needed, *capacity * 2) : needed;
+	T *newArray = new T[newCapacity];
+	for(int i = 0; i < used; i++)
+		newArray[i] = array[i];
+
+	delete[] array;
+	*capacity = newCapacity;
+	return newArray;
+}
+
 //--------------------------------------------------------------------- CLASSES
 
+/* Elements of the Ogre mesh.xml files, read by Object::GetMesh. The vertices
+	and the faces are written in the arrays of the object as soon as they are
+	read : <faces count> and <geometry vertexcount> announce the size of each
+	submesh, before its content. The faces usually come before the vertices,
+	their indices are checked against the vertex count at the end of the
+	submesh.
+	A mesh with one submesh is allocated once, at its final size : the peak
+	memory is the mesh plus the buffer of the reader. The arrays of a mesh
+	with several submeshes may have to grow, the old and the new arrays are
+	then both allocated while they are copied. */
+class MeshXmlHandler : public XmlHandler
+{
+public:
+	const char	*error;				// NULL, or why the parsing was stopped
+	bool			foundSubmeshes;
+
+	MeshXmlHandler(Object *object)
+	{
+		obj = object;
+		error = NULL;
+		foundSubmeshes = false;
+		maxFaces = 0;
+		firstVertex = firstFace = endVertex = endFace = 0;
+		inFaces = inGeometry = inVertex = false;
+	}
+
+	bool StartElement(const char *name, const XmlAttribute *attributes, int num)
+	{
+		if(inVertex)
+		{
+			VertexArrays &verts = obj->arrays;
+			int i = obj->numVerts;
+
+			if(!strcmp(name, "position") && !hasPosition)
+			{
+				verts.x[i] = attributeFloat(attributes, num, "x");
+				verts.y[i] = attributeFloat(attributes, num, "y");
+				verts.z[i] = attributeFloat(attributes, num, "z");
+				hasPosition = true;
+			}
+			else
+			if(!strcmp(name, "normal") && !hasNormal)
+			{
+				verts.nx[i] = attributeFloat(attributes, num, "x");
+				verts.ny[i] = attributeFloat(attributes, num, "y");
+				verts.nz[i] = attributeFloat(attributes, num, "z");
+				hasNormal = true;
+			}
+			else
+			if(!strcmp(name, "texcoord") && !hasTexCoord)
+			{
+				float u = attributeFloat(attributes, num, "u");
+				float v = attributeFloat(attributes, num, "v");
+				verts.u[i] = CLAMP(u, 0.0f, 1.0f);
+				verts.v[i] = CLAMP(v, 0.0f, 1.0f);
+				hasTexCoord = true;
+			}
+			return true;
+		}
+
+		if(inFaces)
+		{
+			if(strcmp(name, "face"))
+				return true;
+			if(obj->numFaces == endFace)
+				return stop("more faces than announced");
+
+			int v1 = attributeInt(attributes, num, "v1");
+			int v2 = attributeInt(attributes, num, "v2");
+			int v3 = attributeInt(attributes, num, "v3");
+			if(!validIndex(v1) || !validIndex(v2) || !validIndex(v3))
+				return stop("vertex index out of range");
+
+			Triangle &t = obj->faces[obj->numFaces++];
+			t.a = firstVertex + v1;
+			t.b = firstVertex + v2;
+			t.c = firstVertex + v3;
+			return true;
+		}
+
+		if(inGeometry)
+		{
+			if(strcmp(name, "vertex"))
+				return true;
+			if(obj->numVerts == endVertex)
+				return stop("more vertices than announced");
+
+			VertexArrays &verts = obj->arrays;
+			int i = obj->numVerts;
+			verts.x[i] = verts.y[i] = verts.z[i] = 0;
+			verts.nx[i] = verts.ny[i] = verts.nz[i] = 0;
+			verts.u[i] = verts.v[i] = 0;
+			inVertex = true;
+			hasPosition = hasNormal = hasTexCoord = false;
+			return true;
+		}
+
+		if(!strcmp(name, "submeshes"))
+		{
+			foundSubmeshes = true;
+		}
+		else
+		if(!strcmp(name, "submesh"))
+		{
+			// The faces index the vertices of their submesh
+			firstVertex = obj->numVerts;
+			firstFace = obj->numFaces;
+			endVertex = obj->numVerts;
+			endFace = obj->numFaces;
+
+			const char *mat = XmlFindAttribute(attributes, num, "material");
+			if(mat)
+				obj->textureID = addMaterialTexture(mat);
+		}
+		else
+		if(!strcmp(name, "faces"))
+		{
+			endFace = obj->numFaces + attributeInt(attributes, num, "count");
+			obj->faces = growArray(obj->faces, obj->numFaces, &maxFaces, endFace);
+			inFaces = true;
+		}
+		else
+		if(!strcmp(name, "geometry"))
+		{
+			endVertex = obj->numVerts + attributeInt(attributes, num, "vertexcount");
+			if(endVertex > TINDEX_MAX + 1)
+				return stop("too many vertices");
+			reserveVertices(endVertex);
+			inGeometry = true;
+		}
+		return true;
+	}
+
+	bool EndElement(const char *name)
+	{
+		if(inVertex)
+		{
+			if(strcmp(name, "vertex"))
+				return true;
+			if(!hasPosition)
+				return stop("vertex without position");
+
+			obj->numVerts++;
+			inVertex = false;
+		}
+		else
+		if(inFaces && !strcmp(name, "faces"))
+			inFaces = false;
+		else
+		if(inGeometry && !strcmp(name, "geometry"))
+			inGeometry = false;
+		else
+		if(!strcmp(name, "submesh"))
+		{
+			// The vertices of the submesh are known now
+			for(int i = firstFace; i < obj->numFaces; i++)
+			{
+				const Triangle &t = obj->faces[i];
+				if(t.a >= obj->numVerts || t.b >= obj->numVerts || t.c >= obj->numVerts)
+					return stop("vertex index out of range");
+			}
+		}
+		return true;
+	}
+
+private:
+	Object	*obj;
+	int		maxFaces;			// allocated size of the faces
+	int		firstVertex, firstFace;	// first vertex and face of the current submesh
+	int		endVertex, endFace;	// end of the arrays announced for the submesh
+	bool		inFaces, inGeometry, inVertex;
+	bool		hasPosition, hasNormal, hasTexCoord;
+
+	/* Grow the vertex arrays of the object to at least needed vertices, like
+		growArray */
+	void reserveVertices(int needed)
+	{
+		VertexArrays &verts = obj->arrays;
+		if(needed <= verts.stride)
+			return;
+
+		verts.numVerts = obj->numVerts;
+		verts.Reserve(verts.stride ? MAX(needed, verts.stride * 2) : needed);
+	}
+
+	// Index v of the current submesh fits in TIndex
+	bool validIndex(int v) const
+	{
+		return v >= 0 && firstVertex + v <= TINDEX_MAX;
+	}
+
+	bool stop(const char *reason)
+	{
+		error = reason;
+		return false;
+	}
+};
+
 Object::Object(void) {
 	numVerts	= 0;
 	numFaces	= 0;
 
-	verts				= NULL;
 	faces				= NULL;
 	materialName	= NULL;
 	textureID		= -1;
@@ -32,6 +298,8 @@ Object::Object(void) {
 
 	numTexVertex = 0;
 	bHasTexture = false;
+
+	bounds.radius = -1;
 }
 
 Object::~Object(void)
@@ -39,8 +307,32 @@ Object::~Object(void)
 	free();	
 }
 
-// import a mesh from an XML file
 int Object::GetMesh(const char* filename)
+{
+	free();
+
+	MeshXmlHandler handler(this);
+	XmlReader reader;
+	int result = reader.Parse(filename, &handler);
+
+	if(result != XmlReader::XML_OK || !handler.foundSubmeshes)
+	{
+		const char *desc = handler.error ? handler.error :
+			(result != XmlReader::XML_OK ? reader.GetErrorDesc() : "no submeshes");
+		printf("Could not load file '%s'. Error='%s' (byte %ld).\n", filename, desc, reader.GetErrorOffset());
+		free();
+		return result == XmlReader::XML_ERROR_FILE ? ERR_READING_FILE : ERR_PARSING_MESH;
+	}
+
+	arrays.numVerts = numVerts;
+	arrays.Finish();
+	calcBounds(arrays, &bounds);
+
+	return numFaces;
+}
+
+// import a mesh from an XML file
+int Object::GetMeshDOM(const char* filename)
 {
 	TiXmlDocument doc( filename );
 	bool loadOkay = doc.LoadFile();
@@ -76,34 +368,15 @@ int Object::GetMesh(const char* filename)
       faceCount+=parseInt(faces->Attribute("count"));		
 	}
 	this->faces=new Triangle[faceCount];
-	this->verts=new Vertex[faceCount*3];
+	arrays.Alloc(faceCount*3);
+	arrays.ClearInputs();
 
 	for (TiXmlElement* smElem = mSubmeshesNode->FirstChildElement();
             smElem != 0; smElem = smElem->NextSiblingElement())
    {
 			const char* mat = smElem->Attribute("material");
 			if (mat)
-			{
-				char* materialName;
-				
-#ifdef TRIM_MATERIAL_NAME
-				// Search for the last occurence of the directory delimiter
-				const char* posDel = strrchr(mat,'/');
-				if(posDel)
-				{
-					materialName = new char[strlen(mat)-(posDel-mat)];
-					strcpy(materialName,posDel+1);
-				}
-				else
-#endif //TRIM_MATERIAL_NAME
-				{
-					materialName = new char[strlen(mat)+1];
-					strcpy(materialName,mat);
-				}
-
-				// Create a new texture
-				textureID = TextureManager::Instance().AddTexture(materialName);
-			}
+				textureID = addMaterialTexture(mat);
 
 		/*
       // Read operation type
@@ -147,8 +420,7 @@ int Object::GetMesh(const char* filename)
 				{
 					if(iVertex==vertexCount)
 					{
-						delete[] this->faces;
-						delete[] this->verts;
+						free();
 						return ERR_PARSING_MESH;
 					}
 
@@ -156,45 +428,44 @@ int Object::GetMesh(const char* filename)
 					TiXmlElement* pos=vbElem->FirstChildElement("position");
 					if(pos)
 					{
-						this->verts[iVertex].coordsLocal.x=parseReal(pos->Attribute("x"));
-						this->verts[iVertex].coordsLocal.y=parseReal(pos->Attribute("y"));
-						this->verts[iVertex].coordsLocal.z=parseReal(pos->Attribute("z"));
+						arrays.x[iVertex]=parseReal(pos->Attribute("x"));
+						arrays.y[iVertex]=parseReal(pos->Attribute("y"));
+						arrays.z[iVertex]=parseReal(pos->Attribute("z"));
 
 						// texture coordinates
 						TiXmlElement* texpos=vbElem->FirstChildElement("texcoord");
 						if(texpos)
 						{
-							this->verts[iVertex].texCoord.u=parseReal(texpos->Attribute("u"));
-							this->verts[iVertex].texCoord.v=parseReal(texpos->Attribute("v"));
+							arrays.u[iVertex]=parseReal(texpos->Attribute("u"));
+							arrays.v[iVertex]=parseReal(texpos->Attribute("v"));
 
-							if(this->verts[iVertex].texCoord.u < 0)
-								this->verts[iVertex].texCoord.u=0;
+							if(arrays.u[iVertex] < 0)
+								arrays.u[iVertex]=0;
 							else
-							if(this->verts[iVertex].texCoord.u > 1)
-								this->verts[iVertex].texCoord.u=1;
+							if(arrays.u[iVertex] > 1)
+								arrays.u[iVertex]=1;
 
-							if(this->verts[iVertex].texCoord.v < 0)
-								this->verts[iVertex].texCoord.v=0;
+							if(arrays.v[iVertex] < 0)
+								arrays.v[iVertex]=0;
 							else
-							if(this->verts[iVertex].texCoord.v > 1)
-								this->verts[iVertex].texCoord.v=1;
+							if(arrays.v[iVertex] > 1)
+								arrays.v[iVertex]=1;
 						}
 
 						// normal
 						TiXmlElement* normal=vbElem->FirstChildElement("normal");
 						if(normal)
 						{
-							this->verts[iVertex].normal.x=parseReal(normal->Attribute("x"));
-							this->verts[iVertex].normal.y=parseReal(normal->Attribute("y"));
-							this->verts[iVertex].normal.z=parseReal(normal->Attribute("z"));
+							arrays.nx[iVertex]=parseReal(normal->Attribute("x"));
+							arrays.ny[iVertex]=parseReal(normal->Attribute("y"));
+							arrays.nz[iVertex]=parseReal(normal->Attribute("z"));
 						}
 
 						iVertex++;
 					}
 					else
 					{
-						delete[] this->faces;
-						delete[] this->verts;
+						free();
 						printf("Number of vertices exceed");
 						return ERR_PARSING_MESH;
 					}
@@ -212,8 +483,7 @@ int Object::GetMesh(const char* filename)
       {
 			if(iTriangle==faceCount)
 			{
-				delete[] this->faces;
-				delete[] this->verts;
+				free();
 				return ERR_PARSING_MESH;
 			}
 
@@ -227,15 +497,76 @@ int Object::GetMesh(const char* filename)
 	this->numFaces=iTriangle;
 	this->numVerts=iVertex;
 
+	arrays.numVerts = numVerts;
+	arrays.Finish();
+	calcBounds(arrays, &bounds);
+
 	return iTriangle;
 }
 
-void Object::free()
+// Positions of a Vertex array or of VertexArrays, for computeBounds
+struct VertexPositions
+{
+	const Vertex *verts;
+	Vector3 operator()(int i) const { return verts[i].coordsLocal; }
+};
+
+struct ArrayPositions
+{
+	const VertexArrays *verts;
+	Vector3 operator()(int i) const { return Vector3(verts->x[i], verts->y[i], verts->z[i]); }
+};
+
+/* The sphere is centered on the box. It is not the smallest one, but it is
+	computed in one pass and is tight enough for culling. */
+template <class Positions>
+static void computeBounds(const Positions &position, int numVerts, Bounds *bounds)
 {
-	if(verts) {
-		delete [] verts;
-		verts = NULL;
+	if(numVerts <= 0)
+	{
+		bounds->min = bounds->max = bounds->center = Vector3(0, 0, 0);
+		bounds->radius = -1;
+		return;
+	}
+
+	bounds->min = bounds->max = position(0);
+	for(int i = 1; i < numVerts; i++)
+	{
+		Vector3 p = position(i);
+		bounds->min.x = MIN(bounds->min.x, p.x);
+		bounds->min.y = MIN(bounds->min.y, p.y);
+		bounds->min.z = MIN(bounds->min.z, p.z);
+		bounds->max.x = MAX(bounds->max.x, p.x);
+		bounds->max.y = MAX(bounds->max.y, p.y);
+		bounds->max.z = MAX(bounds->max.z, p.z);
 	}
+
+	bounds->center = (bounds->min + bounds->max) * 0.5f;
+
+	float radius2 = 0;
+	for(int i = 0; i < numVerts; i++)
+	{
+		Vector3 d = position(i) - bounds->center;
+		radius2 = MAX(radius2, d.x*d.x + d.y*d.y + d.z*d.z);
+	}
+	bounds->radius = sqrt(radius2);
+}
+
+void calcBounds(const Vertex *verts, int numVerts, Bounds *bounds)
+{
+	VertexPositions position = {verts};
+	computeBounds(position, numVerts, bounds);
+}
+
+void calcBounds(const VertexArrays &verts, Bounds *bounds)
+{
+	ArrayPositions position = {&verts};
+	computeBounds(position, verts.numVerts, bounds);
+}
+
+void Object::free()
+{
+	arrays.Free();
 	if(faces) {
 		delete [] faces;
 		faces = NULL;
@@ -250,4 +581,120 @@ void Object::free()
 	}
 
 	numVisible	= 0;
-}
\ No newline at end of file
+}
+
+/* Grid of n*n quads in the plane z = 0, written like the exporter does. n is
+	at most 255 : the (n+1)^2 vertices are indexed by TIndex. */
+static bool writeGridMesh(const char *filename, int n)
+{
+	FILE *file = fopen(filename, "w");
+	if(!file)
+		return false;
+
+	int row = n + 1;
+	fprintf(file, "<mesh>\n\t<submeshes>\n\t\t<submesh usesharedvertices=\"false\">\n");
+	fprintf(file, "\t\t\t<faces count=\"%d\">\n", 2 * n * n);
+	for(int i = 0; i < n; i++)
+	{
+		for(int j = 0; j < n; j++)
+		{
+			int a = i * row + j;
+			fprintf(file, "\t\t\t\t<face v1=\"%d\" v2=\"%d\" v3=\"%d\"/>\n", a, a + row, a + 1);
+			fprintf(file, "\t\t\t\t<face v1=\"%d\" v2=\"%d\" v3=\"%d\"/>\n", a + 1, a + row, a + row + 1);
+		}
+	}
+	fprintf(file, "\t\t\t</faces>\n");
+
+	fprintf(file, "\t\t\t<geometry vertexcount=\"%d\">\n", row * row);
+	fprintf(file, "\t\t\t\t<vertexbuffer positions=\"true\" normals=\"true\" texture_coords=\"1\">\n");
+	for(int i = 0; i < row; i++)
+	{
+		for(int j = 0; j < row; j++)
+		{
+			float u = (float)j / n, v = (float)i / n;
+			fprintf(file, "\t\t\t\t\t<vertex>\n");
+			fprintf(file, "\t\t\t\t\t\t<position x=\"%f\" y=\"%f\" z=\"%f\"/>\n", u * 2 - 1, v * 2 - 1, 0.0f);
+			fprintf(file, "\t\t\t\t\t\t<normal x=\"%f\" y=\"%f\" z=\"%f\"/>\n", 0.0f, 0.0f, 1.0f);
+			fprintf(file, "\t\t\t\t\t\t<texcoord u=\"%f\" v=\"%f\"/>\n", u, v);
+			fprintf(file, "\t\t\t\t\t</vertex>\n");
+		}
+	}
+	fprintf(file, "\t\t\t\t</vertexbuffer>\n\t\t\t</geometry>\n\t\t</submesh>\n\t</submeshes>\n</mesh>\n");
+
+	bool ok = !ferror(file);
+	fclose(file);
+	return ok;
+}
+
+// Same vertices and faces, bit for bit
+static bool sameMesh(const Object &a, const Object &b)
+{
+	if(a.numVerts != b.numVerts || a.numFaces != b.numFaces)
+		return false;
+
+	const VertexArrays &va = a.arrays, &vb = b.arrays;
+	for(int i = 0; i < a.numVerts; i++)
+	{
+		if(va.x[i] != vb.x[i] || va.y[i] != vb.y[i] || va.z[i] != vb.z[i] ||
+			va.nx[i] != vb.nx[i] || va.ny[i] != vb.ny[i] || va.nz[i] != vb.nz[i] ||
+			va.u[i] != vb.u[i] || va.v[i] != vb.v[i])
+			return false;
+	}
+	for(int i = 0; i < a.numFaces; i++)
+	{
+		const Triangle &fa = a.faces[i], &fb = b.faces[i];
+		if(fa.a != fb.a || fa.b != fb.b || fa.c != fb.c)
+			return false;
+	}
+	return true;
+}
+
+/* The meshes are written in the temporary directory, in BENCHMARK_MESH_FILE
+	which is removed at the end. The biggest one is about 14 MB, its DOM
+	more than 100 MB. */
+void Object::BenchmarkMeshLoaders(void)
+{
+#ifdef GP2X_MODE
+	static const int sizes[] = {10000};
+#else
+	static const int sizes[] = {10000, 50000, 100000};
+#endif
+	static const int numSizes = sizeof(sizes) / sizeof(sizes[0]);
+
+	const char *dir = getenv(TEMP_DIRECTORY_ENV);
+	if(!dir || !*dir)
+		dir = TEMP_DIRECTORY;
+	char *filename = new char[strlen(dir) + strlen(SEPARATOR BENCHMARK_MESH_FILE) + 1];
+	strcpy(filename, dir);
+	strcat(filename, SEPARATOR BENCHMARK_MESH_FILE);
+
+	for(int s = 0; s < numSizes; s++)
+	{
+		int n = MIN((int)ceil(sqrt(sizes[s] / 2.0)), 255);
+		if(!writeGridMesh(filename, n))
+		{
+			printf("Mesh loaders : can't write %s\n", filename);
+			break;
+		}
+
+		Object dom, stream;
+		clock_t start = clock();
+		int faces = dom.GetMeshDOM(filename);
+		clock_t middle = clock();
+		stream.GetMesh(filename);
+		clock_t end = clock();
+
+		double domMs = 1000.0 * (middle - start) / CLOCKS_PER_SEC;
+		double streamMs = 1000.0 * (end - middle) / CLOCKS_PER_SEC;
+		double output = ((double)stream.arrays.GetSize() +
+							  (double)stream.numFaces * sizeof(Triangle)) / (1024 * 1024);
+
+		printf("Mesh loaders %7d faces : TinyXML %7.0f ms, streaming %6.0f ms (x%.1f), "
+				 "%.1f MB of mesh + %d KB of buffer, %s\n",
+				 faces, domMs, streamMs, streamMs > 0 ? domMs / streamMs : 0.0, output,
+				 XML_READER_BUFFER / 1024, sameMesh(dom, stream) ? "same mesh" : "MESHES DIFFER");
+	}
+
+	remove(filename);
+	delete[] filename;
+}
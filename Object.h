@@ -13,6 +13,7 @@
 //-------------------------------------------------------------------- INCLUDES
 #include "defs.h"
 #include "Body.h"
+#include "VertexArrays.h"
 #include "tinyxml/tinyxml.h" // xml parsing
 
 //---------------------------------------------------------------------- MACROS
@@ -65,13 +66,13 @@ public:
 	int				numVerts;				// number of vertices
 	int				numFaces;				// number of faces
 	int				numTexVertex;			// number of vertices texture
-	Vertex			*verts;					// vertices
+	VertexArrays	arrays;					// vertices, one array per component (written by the loaders)
 	Triangle			*faces;					// faces
 	Vertex_TexCoord	*texVerts;				// vertices texture
 	bool					bHasTexture;
 
 	int			numVisible,				// used internally. number of visible polygons
-					*visible;				// used internally. tells which polygons are visible (in sorted order)	
+					*visible;				// used internally. depth order of the faces in the previous frame	
 
 	// To keep ASE compatinility
 	// TODO : The ASE loader has to be refactored to be better integrated with
@@ -81,16 +82,33 @@ public:
 
 	int textureID;
 
+	Bounds bounds;							// computed by the loaders
+
 	Body body;
 
 	Object(void);
 	~Object(void);
 	
-	// import the ASE models from the specified xml file
+	/* import the Ogre mesh from the specified xml file, in a single pass (see
+		XmlReader). Returns the number of faces or an error (< 0) */
 	int GetMesh(const char* filename);
+
+	// Same as GetMesh, with the TinyXML document of the whole file
+	int GetMeshDOM(const char* filename);
+
 	void free();
 
+	/* Print the load time of the two loaders on generated meshes of 10k to
+		100k triangles, and check that they build the same mesh */
+	static void BenchmarkMeshLoaders(void);
+
 	friend class CLoadASE;
 };
 
+//------------------------------------------------------------------- FUNCTIONS
+
+// Compute the bounding box and the bounding sphere of the specified vertices
+void calcBounds(const Vertex *verts, int numVerts, Bounds *bounds);
+void calcBounds(const VertexArrays &verts, Bounds *bounds);
+
 #endif // OBJECT_ASE_H
@@ -7,6 +7,7 @@
 */
 
 //-------------------------------------------------------------------- INCLUDES
+#include "Object.h"
 #include "Object_3DS.h"
 #include "Log.h"
 
@@ -23,6 +24,7 @@ Object_3DS::Object_3DS()
 {
 	numMats		= 0;
 	mats		= NULL;
+	bounds.radius = -1;
 }
 
 bool Object_3DS::load3DS(const char *filename) {
@@ -110,9 +112,10 @@ bool Object_3DS::load3DS(const char *filename) {
 
 	freeLists();
 	
-	// finally calculate normals
+	// finally calculate normals and bounding volumes
 
 	calcNormals();
+	calcBounds(verts, numVerts, &bounds);
 
 	// good to go
 
@@ -86,6 +86,7 @@ private:
 	Vertex			*verts;					// vertices
 	Face				*faces;					// faces
 	int				*visible;				// used internally. tells which polygons are visible (in sorted order)
+	Bounds			bounds;					// bounding volumes
 
 
 	void calcNormals(void);
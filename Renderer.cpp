@@ -15,6 +15,7 @@
 #include "Application.h"
 #include "Log.h"
 #include "Renderer.h"
+#include "TileBinner.h"
 
 #ifndef USE_SDL
 #include "minimal.h"
@@ -36,9 +37,43 @@ Renderer::Renderer(Display* d)
 {
 	display=d;
 	currentTexture=0;
+	faceTexture=0;
+	mipmapping=true;
+	hsrMode=HSR_PAINTER;
+	zBuffer=NULL;
+	depthEpoch=0;
+	binner=new TileBinner(this);
+	rasterCore=RASTER_SCANLINE;
+	faceCulling=CULL_BACK;
+	memset(&stats, 0, sizeof(FrameStats));
+	memset(&lastStats, 0, sizeof(FrameStats));
+	perspectiveSpan=0;
+	resetAllSpans=false;
+	clipVerts.Alloc(5);		// the triangle and the 2 vertices on the plane
+#ifdef FIXED_PIPELINE
+	fixedPipeline=true;
+#else
+	fixedPipeline=false;
+#endif
+	SetDepthFormat(DEPTH_16);
 	Init();
 }
 
+DepthSorter& Renderer::GetDepthSorter()
+{
+	return depthSorter;
+}
+
+FrameArena& Renderer::GetFrameArena()
+{
+	return frameArena;
+}
+
+SpanFiller& Renderer::GetSpanFiller()
+{
+	return spanFiller;
+}
+
 Renderer::~Renderer(void)
 {
 	if(currentTexture)
@@ -46,6 +81,8 @@ Renderer::~Renderer(void)
 		delete[] currentTexture->data;
 		delete currentTexture;
 	}
+	delete[] (uint*)zBuffer;
+	delete binner;
 	Deinit();
 }
 
@@ -128,6 +165,12 @@ void Renderer::calcFocal(void)
 {
 	halfVpW = (float) (vp[2] - 1) * 0.5f;
 	halfVpH = (float) (vp[3] - 1) * 0.5f;
+#ifdef FIXED_PIPELINE
+	centerFixed[0] = Fixed16(halfVpW + vp[0]).raw;
+	centerFixed[1] = Fixed16(halfVpH + vp[1]).raw;
+	clipFixed[0] = Fixed16(halfVpW + 1).raw;
+	clipFixed[1] = Fixed16(halfVpH + 1).raw;
+#endif
 	focal = halfVpW * cot( degstorads(fov / 2) );
 }
 
@@ -150,455 +193,1798 @@ void Renderer::SetCurrentTexture(Texture* texture)
 	currentTexture = texture;
 }
 
-void Renderer::RenderObject(Object *obj)
-{ 
-	// Loop through the tris and transform their vertices
-	int a,b,c;
-	Vector3 v1,v2;
-	int* visible=new int[obj->numFaces];
-	int numVisible=0;
-
-	// Load the texture associated to the object
-	TextureManager::Instance().LoadTexture(obj->textureID);
+void Renderer::SetHSRMode(int mode)
+{
+	hsrMode = mode;
 
-	for(int i = 0; i < obj->numFaces; i++)
-	{		
-		a=obj->faces[i].a;
-		b=obj->faces[i].b;
-		c=obj->faces[i].c;
-		
-		obj->verts[a].coordsWorld = (obj->body.pos + obj->verts[a].coordsLocal) * matWorld;
-		obj->verts[b].coordsWorld = (obj->body.pos + obj->verts[b].coordsLocal) * matWorld;
-		obj->verts[c].coordsWorld = (obj->body.pos + obj->verts[c].coordsLocal) * matWorld;
-		
-		obj->faces[i].cenZ = (obj->verts[a].coordsWorld.z + 
-									obj->verts[b].coordsWorld.z + 
-									obj->verts[c].coordsWorld.z)	/ 3;			
-
-		obj->faces[i].normal = (obj->verts[a].normal + 
-									obj->verts[b].normal + 
-									obj->verts[c].normal);
-		obj->faces[i].normal /= 3;
-
-#ifdef BACK_FACE_CULLING
-		/* face not visible if dot product of surface normal and projector to any
-		point on surface is nonnegative */
-		v1 = obj->verts[b].coordsWorld - obj->verts[a].coordsWorld;
-		v2 = obj->verts[c].coordsWorld - obj->verts[a].coordsWorld;
-		float norm = v1.x*v2.y - v1.y*v2.x;		        
-		//if (norm>=0)
-		if (norm<0)
-#endif //BACK_FACE_CULLING
-		{
-			visible[numVisible] = i;
-			numVisible++;
-		}
+	if(hsrMode == HSR_ZBUFFER && !zBuffer)
+	{
+		// Big enough for both formats
+		zBuffer = new uint[SCR_WIDTH*SCR_HEIGHT];
+		SetDepthFormat(depthFormat);
 	}
+}
 
-	// Sort using selection algorithm
-	int temp=obj->numFaces;
-	obj->numFaces=numVisible;
-	int pos;
-	for(int i = 0; i < obj->numFaces - 1; i++)
-	{
-		pos = i;
-		
-		for(int j = i + 1; j < obj->numFaces; j++)
-		{
-			if(obj->faces[visible[j]].cenZ > obj->faces[visible[pos]].cenZ)
-				pos = j;
-		}
+int Renderer::GetHSRMode(void) const
+{
+	return hsrMode;
+}
 
-		if(pos != i) 
-        {
-			int temp = visible[i];
-			visible[i] = visible[pos];
-			visible[pos] = temp;
-		}
-	}
+void Renderer::SetMipmapping(bool enable)
+{
+	mipmapping = enable;
+}
 
-	// Render
-	Vector3 L(0,0,1);
-	L.Normalize();
-	unsigned char col=40;
-	unsigned char AMBIANT=20;
-	char DIFFUSE=215;
-	for(int i = 0; i < obj->numFaces; i++)
-	{
-		float angle=Dot(obj->faces[i].normal,L);
-		if (angle<0)
-			col = AMBIANT;
-		else
-			col = AMBIANT + (float) DIFFUSE * angle;
+bool Renderer::GetMipmapping(void) const
+{
+	return mipmapping;
+}
 
-		rasterizeFace(obj,visible[i],fabs(angle));
+/* 0 selects affine texturing, otherwise the length of the affine spans
+	between two exact texels, rounded to a power of 2 */
+void Renderer::SetPerspective(int span)
+{
+	perspectiveSpan = 0;
+	if(span > 0)
+	{
+		perspectiveSpan = 2;
+		while(perspectiveSpan < span && perspectiveSpan < MAX_PERSPECTIVE_SPAN)
+			perspectiveSpan <<= 1;
 	}
-	delete[] visible;
-	obj->numFaces=temp;
 }
 
-/* Rasterize the index-th face of the specified object
-	Vertices have to be specified using the following system coordinates.
-	They also have to be ordered in a clockwize direction.
-	^ +y
-	|
-	|
-	|	
-	(0,0)-----> +x
-	/
-  /
-  +z
-
-  System coordinate used for texture mapping
-	^ -v
-	|
-	|
-	|		
-  (0,0)-----> +u
-  */
-void Renderer::rasterizeFace(Object* obj,int index,float col)
+int Renderer::GetPerspective(void) const
 {
-	Vertex *verts[3];
-   // Get pointers to vertices
-	verts[0] = &obj->verts[obj->faces[index].a];
-	verts[1] = &obj->verts[obj->faces[index].b];
-	verts[2] = &obj->verts[obj->faces[index].c];	
+	return perspectiveSpan;
+}
 
-	// Project points
-	project(verts[0]);
-	project(verts[1]);
-	project(verts[2]);
+void Renderer::SetDepthFormat(int format)
+{
+	depthFormat = format;
 
-	// Init span information
-	minY = 10000;
-	maxY = -10000;
+	if(depthFormat == DEPTH_16)
+		depthScale = ZBUFFER_MAX16 * ZBUFFER_NEAR;
+	else
+		depthScale = ZBUFFER_MAX32 * ZBUFFER_NEAR;
 
-	for(int i = 0; i < SCR_HEIGHT; i++)
+	// The content of the buffer is meaningless in the new format
+	if(zBuffer)
 	{
-		spans[i].xStart = minY;
-		spans[i].xEnd = maxY;
+		memset(zBuffer, 0, SCR_WIDTH*SCR_HEIGHT*sizeof(uint));
+		depthEpoch = ZBUFFER_MAX32 + 1;
 	}
+}
 
-	// Scan-convert the triangle
-	scanEdge(verts[0], verts[1]);
-	scanEdge(verts[1], verts[2]);
-	scanEdge(verts[2], verts[0]);	
+int Renderer::GetDepthFormat(void) const
+{
+	return depthFormat;
+}
 
-	Screen screen=display->GetScreen();	
+void Renderer::SetRasterCore(int core)
+{
+	rasterCore = core;
+}
 
-	// Looking for the point having texture coord (u,v)=(0,0)
-	int UVIndex0=-1;
-	TRIANGLE_TYPE triangle_type = GENERAL;
-	int indexMiddle=-1;
-	for(int i=0;(i<3) && (UVIndex0==-1);i++)
-	{
-		for(int j=0;j<3;j++)
-		{
-			if(j==i) continue;
-			if(verts[i]->scr[1] == verts[j]->scr[1])
-			{
-				if(verts[i]->scr[1] > verts[3-i-j]->scr[1])
-				{
-					triangle_type=FLAT_TOP; // 2 upper y-coordinates
-					UVIndex0 = 3-i-j;					
-				}
-				else
-				{
-					triangle_type=FLAT_BOTTOM; // 2 lower y-coordinates
+int Renderer::GetRasterCore(void) const
+{
+	return rasterCore;
+}
 
-					if(verts[i]->scr[0] < verts[j]->scr[0])
-						UVIndex0 = i;
-					else
-						UVIndex0 = j;
-				}
-				break;
-			}
-			else
-			if(verts[i]->scr[1] < verts[j]->scr[1])
-			{				
-				if(verts[j]->scr[1] < verts[3-i-j]->scr[1])
-				{
-					// GENERAL triangle
-					UVIndex0=i;
-					indexMiddle=j;
-					break;
-				}
-			}
-		}
-	}
+void Renderer::SetFaceCulling(int mode)
+{
+	faceCulling = mode;
+}
 
-	/* Vertices are ordered in a clockwize manner (before and after projection)
-		sUVIndex points to the pixel having the lowest x and y coordinates
-		In consequence, the next pixel (sUVIndex+1) is on the right and the one
-		after is on the left */
-	iLeft = UVIndex0+1;
-	if(iLeft>2) iLeft=0;
-	iRight = iLeft+1;
-	if(iRight>2) iRight=0;
-	
-	Vector2 vAB;
-	vAB.x = verts[UVIndex0]->scr[0] - verts[iLeft]->scr[0];
-	vAB.y = verts[UVIndex0]->scr[1] - verts[iLeft]->scr[1];
-	Vector2 vAC;
-	vAC.x = verts[iRight]->scr[0] - verts[iLeft]->scr[0];
-	vAC.y = verts[iRight]->scr[1] - verts[iLeft]->scr[1];
-	float fNorm = vAB.x*vAC.y - vAB.y*vAC.x;
-	if(fNorm<0)
-	{
-		SWAP(fTemp,iLeft,iRight);
-	}
+int Renderer::GetFaceCulling(void) const
+{
+	return faceCulling;
+}
 
-	/* Initialize the 3 texture coordinates for the 3 vertices of the specified
-		triangle.
-		Important : Vertices are ordered in a clockwize manner (before and after
-		projection)
-		*/
-	u0=verts[UVIndex0]->texCoord.u*currentTexture->width;
-	v0=verts[UVIndex0]->texCoord.v*currentTexture->height;
+/* Switch between the float and the fixed point pipelines. Only the float
+	one is compiled without FIXED_PIPELINE, enable is then ignored. */
+void Renderer::SetFixedPipeline(bool enable)
+{
+#ifdef FIXED_PIPELINE
+	fixedPipeline = enable;
+#endif
+}
 
-	u1=verts[iLeft]->texCoord.u*currentTexture->width;
-	v1=verts[iLeft]->texCoord.v*currentTexture->height;
+bool Renderer::GetFixedPipeline(void) const
+{
+	return fixedPipeline;
+}
 
-	u2=verts[iRight]->texCoord.u*currentTexture->width;
-	v2=verts[iRight]->texCoord.v*currentTexture->height;
+void Renderer::SetRasterThreads(int num)
+{
+	binner->SetNumThreads(num);
+}
 
-	diffY=1.0/(maxY-minY);
+int Renderer::GetRasterThreads(void) const
+{
+	return binner->GetNumThreads();
+}
 
-	if(triangle_type == FLAT_TOP)
-	{
-		ul=u0;
-		vl=v0;
-		ur=u0;
-		vr=v0;
+const FrameStats& Renderer::GetFrameStats(void) const
+{
+	return lastStats;
+}
 
-		if(currentTexture)
-		{
-			pixel=currentTexture->data;
-			dudyl=(float)(u1-u0)*diffY;
-			dvdyl=(float)(v1-v0)*diffY;
-			dudyr=(float)(u2-u0)*diffY;
-			dvdyr=(float)(v2-v0)*diffY;
-		}
+void Renderer::BeginFrame(void)
+{
+	memset(&stats, 0, sizeof(FrameStats));
+	queue.clear();
+	frameArena.Reset();
+	binner->Clear();
+
+	if(hsrMode == HSR_ZBUFFER)
+		clearDepth();
+	else
+	if(hsrMode == HSR_SBUFFER)
+		sBuffer.Clear();
+}
+
+void Renderer::EndFrame(void)
+{
+	// Render the submitted objects, then the binned faces
+	flushQueue();
+	binner->Flush();
+
+	// The span buffer textures each visible pixel once, at the end of the frame
+	if(hsrMode == HSR_SBUFFER)
+		sBuffer.Flush(display->GetScreen(), spanFiller);
+
+	stats.scratchHighWater = (long)frameArena.GetHighWaterMark();
+	lastStats = stats;
+}
+
+void Renderer::clearDepth(void)
+{
+	if(depthFormat == DEPTH_16)
+	{
+		memset(zBuffer, 0, SCR_WIDTH*SCR_HEIGHT*sizeof(word));
 	}
 	else
-	if(triangle_type == FLAT_BOTTOM)
 	{
-		if(currentTexture)
+		/* Fast clear : the 8 high bits of the 32 bits values store a frame
+			counter, so that any depth written during this frame is greater than
+			the depths of the previous frames. The memory is only cleared when
+			the counter wraps, i.e. every 255 frames. */
+		depthEpoch += ZBUFFER_MAX32 + 1;
+		if(depthEpoch == 0)
 		{
-			pixel=currentTexture->data;
-			dudyl=(float)(u1-u0)*diffY;
-			dvdyl=(float)(v1-v0)*diffY;
-			dudyr=(float)(u1-u2)*diffY;
-			dvdyr=(float)(v1-v2)*diffY;
+			memset(zBuffer, 0, SCR_WIDTH*SCR_HEIGHT*sizeof(uint));
+			depthEpoch = ZBUFFER_MAX32 + 1;
 		}
+	}
+}
 
-		ul=u0;
-		vl=v0;
-		ur=u2;
-		vr=v2;
+/* Compute the plane value = a*x + b*y + c in screen space going through the
+	values w0, w1 and w2 at the projected vertices */
+void Renderer::calcPlane(const VertexArrays &verts, const int *idx, float w0, float w1, float w2,
+								 float *a, float *b, float *c)
+{
+	float x0 = verts.sx[idx[0]], y0 = verts.sy[idx[0]];
+	float dx1 = verts.sx[idx[1]] - x0, dy1 = verts.sy[idx[1]] - y0;
+	float dx2 = verts.sx[idx[2]] - x0, dy2 = verts.sy[idx[2]] - y0;
+
+	float dw1 = w1 - w0;
+	float dw2 = w2 - w0;
+
+	float det = dx1*dy2 - dx2*dy1;
+	if(det >= -FLT_ERROR && det <= FLT_ERROR)
+	{
+		*a = 0;
+		*b = 0;
 	}
 	else
 	{
-		// GENERAL
-		ul=u0;
-		vl=v0;
-		ur=u0;
-		vr=v0;
-
-		if(currentTexture)
-		{
-			pixel=currentTexture->data;
-			dudyl=(float)(verts[iLeft]->texCoord.u-verts[UVIndex0]->texCoord.u)*currentTexture->width/(verts[iLeft]->scr[1]-minY);
-			dvdyl=(float)(verts[iLeft]->texCoord.v-verts[UVIndex0]->texCoord.v)*currentTexture->height/(verts[iLeft]->scr[1]-minY);
-			dudyr=(float)(verts[iRight]->texCoord.u-verts[UVIndex0]->texCoord.u)*currentTexture->width/(verts[iRight]->scr[1]-minY);
-			dvdyr=(float)(verts[iRight]->texCoord.v-verts[UVIndex0]->texCoord.v)*currentTexture->height/(verts[iRight]->scr[1]-minY);
-		}
+		det = 1.0f / det;
+		*a = (dw1*dy2 - dw2*dy1) * det;
+		*b = (dx1*dw2 - dx2*dw1) * det;
 	}
+	*c = w0 - *a*x0 - *b*y0;
+}
 
-	// Update yMiddle
-	if(indexMiddle != -1)
-		yMiddle = verts[indexMiddle]->scr[1];
-	else
-		yMiddle = maxY;
+/* Compute the plane of 1/z in screen space for the specified face. 1/z (and
+	not z) varies linearly across the projected face. */
+void Renderer::calcDepthPlane(const VertexArrays &verts, const int *idx, RasterFace *face)
+{
+	calcPlane(verts, idx,
+				 depthScale / verts.wz[idx[0]],
+				 depthScale / verts.wz[idx[1]],
+				 depthScale / verts.wz[idx[2]],
+				 &face->depthA, &face->depthB, &face->depthC);
+}
 
-#ifdef DEBUG
-	int cptError=0;
-#endif //DEBUG
+/* Compute the texel planes of the specified face. With perspective correct
+	texturing u and v are not linear in screen space, but u/z, v/z and 1/z
+	are. */
+void Renderer::calcTexturePlanes(const VertexArrays &verts, const int *idx, RasterFace *face)
+{
+	face->perspective = faceTexture ? perspectiveSpan : 0;
+	face->wA = face->wB = face->wC = 0;
 
-	for(int i = minY; i < maxY; i++)
+	if(!faceTexture)
 	{
-		if(i == yMiddle)
-		{
-			if(indexMiddle == iLeft)
-			{
-				// Change left side
-				ul=verts[iLeft]->texCoord.u*currentTexture->width;
-				vl=verts[iLeft]->texCoord.v*currentTexture->height;
-				// Going from left to right
-				dudyl=(float)(verts[iRight]->texCoord.u-verts[iLeft]->texCoord.u)*currentTexture->width/(maxY-verts[indexMiddle]->scr[1]);
-				dvdyl=(float)(verts[iRight]->texCoord.v-verts[iLeft]->texCoord.v)*currentTexture->height/(maxY-verts[indexMiddle]->scr[1]);
-			}
-			else
-			{
-				// Change right side
-				ur=verts[iRight]->texCoord.u*currentTexture->width;
-				vr=verts[iRight]->texCoord.v*currentTexture->height;
-				// Going from right to left
-				dudyr=(float)(verts[iLeft]->texCoord.u-verts[iRight]->texCoord.u)*currentTexture->width/(maxY-verts[indexMiddle]->scr[1]);
-				dvdyr=(float)(verts[iLeft]->texCoord.v-verts[iRight]->texCoord.v)*currentTexture->height/(maxY-verts[indexMiddle]->scr[1]);
-			}
-		}
+		face->uA = face->uB = face->uC = 0;
+		face->vA = face->vB = face->vC = 0;
+		return;
+	}
 
-		// Get the start and end points of the current span		
-		x1 = spans[i].xStart;
-		x2 = spans[i].xEnd;
+	float u[3], v[3];
+	for(int i = 0; i < 3; i++)
+	{
+		u[i] = verts.u[idx[i]] * faceTexture->width;
+		v[i] = verts.v[idx[i]] * faceTexture->height;
+	}
 
-		// Clip span
-		if(x1 >= SCR_WIDTH || (x2 < 0))
-			continue;
-		if(x1 < 0)
-		{
-			x1 = 0;
-		}
-		if(x2 >= SCR_WIDTH)
+	if(face->perspective)
+	{
+		float w[3];
+		for(int i = 0; i < 3; i++)
 		{
-			x2 = SCR_WIDTH - 1;
+			w[i] = 1.0f / verts.wz[idx[i]];
+			u[i] *= w[i];
+			v[i] *= w[i];
 		}
+		calcPlane(verts, idx, w[0], w[1], w[2], &face->wA, &face->wB, &face->wC);
+	}
 
-		ui=ul;
-		vi=vl;
+	calcPlane(verts, idx, u[0], u[1], u[2], &face->uA, &face->uB, &face->uC);
+	calcPlane(verts, idx, v[0], v[1], v[2], &face->vA, &face->vB, &face->vC);
+}
 
-		// Compute u,v interpolants
-		du=(ur-ul);
-		dv=(vr-vl);
+/* Select the mip level of the current texture for the projected triangle
+	idx of verts, from the ratio of its areas in texels and in pixels. Each level
+	divides the ratio by 4 : the level is the nearest one to a texel per
+	pixel. */
+const Texture* Renderer::selectMipmap(const VertexArrays &verts, const int *idx)
+{
+	const Texture *texture = currentTexture;
+	if(!texture)
+		return NULL;
+
+	int i0 = idx[0], i1 = idx[1], i2 = idx[2];
+	float du1 = verts.u[i1] - verts.u[i0];
+	float dv1 = verts.v[i1] - verts.v[i0];
+	float du2 = verts.u[i2] - verts.u[i0];
+	float dv2 = verts.v[i2] - verts.v[i0];
+	float texels = fabs(du1*dv2 - du2*dv1) * 0.5f * texture->size;
 
-		dx=x2-x1;
-		if(dx!=0)
+	float pixels = fabs((verts.sx[i1] - verts.sx[i0]) * (verts.sy[i2] - verts.sy[i0]) -
+							  (verts.sy[i1] - verts.sy[i0]) * (verts.sx[i2] - verts.sx[i0])) * 0.5f;
+
+	if(mipmapping)
+	{
+		while(texture->mipmap && texels >= 2*pixels)
 		{
-			du/=dx;
-			dv/=dx;
+			texture = texture->mipmap;
+			texels *= 0.25f;
 		}
+	}
 
-		Screen vidBits = &screen[x1+i*SCR_WIDTH];
+	stats.numTexels += (long)texels;
+	return texture;
+}
 
-		// Render span			
-		for(int j = x1; j <= x2; j++)
-		{
-			if(Application::Instance().RenderingMode & Application::TEXTURED)
-			{
-				int indexPixel = int (ui) + (int) vi*currentTexture->width;
-				//if(ui >= 0 && ui <= currentTexture->width && vi >= 0 && vi <= currentTexture->height)
-				if(indexPixel < 0)
-					indexPixel=0;
-				if(indexPixel >= currentTexture->size)
-					indexPixel=currentTexture->size-1;
-				*vidBits = pixel[indexPixel];
-
-//				else
-//				{
-//					*vidBits = col; // DEBUG
-//#ifdef DEBUG
-//					cptError++;
-//#endif //DEBUG
-//				}
-			}
-			if(Application::Instance().RenderingMode & Application::WIREFRAME)
-			{
-				if(j==x1 || j==x2 || i==minY || i==maxY-1)
-					*vidBits=0;
-			}
+/* Render the specified object immediately, with its own texture. See
+	SubmitObject to render a set of objects sharing textures. */
+void Renderer::RenderObject(Object *obj)
+{
+	stats.numObjects++;
 
-			vidBits++;
+	// Skip the objects outside the view frustum before any transform
+	float depth;
+	int cull = cullObject(obj, &depth);
+	if(cull == CULL_OUTSIDE)
+	{
+		stats.numCulled++;
+		return;
+	}
 
-			// interpolate u,v
-			ui+=du;
-			vi+=dv;
-		}
+	bindTexture(obj->textureID);
+	renderObject(obj, cull);
+}
 
-		//interploate u,v along right and left side
-		ul+=dudyl;
-		vl+=dvdyl;
+/* Queue the specified object, with the current world matrix, to be rendered
+	by EndFrame. The queue is sorted by texture, then by depth, so each
+	texture is bound once per frame and the objects sharing it are drawn
+	together, from front to back. The painter's algorithm needs the objects
+	from back to front : the depth comes first in that mode. */
+void Renderer::SubmitObject(Object *obj)
+{
+	stats.numObjects++;
 
-		ur+=dudyr;
-		vr+=dvdyr;
-	}
-#ifdef DEBUG_MODE
-	if(cptError>10)
+	QueueItem item;
+	float depth;
+	item.cull = cullObject(obj, &depth);
+	if(item.cull == CULL_OUTSIDE)
 	{
-		std::list<int>::iterator where = std::find(listErrorFaces.begin(), listErrorFaces.end(), index);
-		if(where == listErrorFaces.end())
-		{
-			listErrorFaces.push_back(index);
-			sysLog << "cptError: " << cptError <<"\n";
-			sysLog << "Rotation: " << Application::Instance().GetRotation()<<"\n";
-			sysLog << "index: " << index <<"\n";
-			sysLog << "triangle_type: " << triangle_type <<"\n";			
-			sysLog << "a: " << obj->faces[index].a <<", ";
-			sysLog << "b: " << obj->faces[index].b <<", ";
-			sysLog << "c: " << obj->faces[index].c <<"\n";		
+		stats.numCulled++;
+		return;
+	}
 
-			Vector3 vAB = obj->verts[obj->faces[index].b].coordsWorld - obj->verts[obj->faces[index].a].coordsWorld;
-			Vector3 vAC = obj->verts[obj->faces[index].c].coordsWorld - obj->verts[obj->faces[index].a].coordsWorld;
-			float fNorm = vAB.x*vAC.y - vAB.y*vAC.x;
-			//sysLog << "vA: " << obj->verts[obj->faces[index].a].coordsWorld <<"\n";
-			//sysLog << "vB: " << obj->verts[obj->faces[index].b].coordsWorld <<"\n";
-			//sysLog << "vC: " << obj->verts[obj->faces[index].c].coordsWorld <<"\n";
-			sysLog << "vA=[" <<
-				obj->verts[obj->faces[index].a].scr[0] << " " <<
-				obj->verts[obj->faces[index].a].scr[1] <<"]\n";
-			sysLog << "vB=[" <<
-				obj->verts[obj->faces[index].b].scr[0] << " " <<
-				obj->verts[obj->faces[index].b].scr[1] <<"]\n";
-			sysLog << "vC=[" <<
-				obj->verts[obj->faces[index].c].scr[0] << " " <<
-				obj->verts[obj->faces[index].c].scr[1] <<"]\n";			
+	item.obj = obj;
+	item.matWorld = matWorld;
 
-			float UVNorm = (u1 - u0)*(v2 - v0) - (v1 - v0)*(u2 - u0);
+	// Logarithmic buckets, the precision is relative to the depth
+	int bucket = 0;
+	if(depth > NEAR_PLANE)
+		bucket = (int)(log(depth / NEAR_PLANE) * QUEUE_DEPTH_BUCKETS / log(FAR_PLANE / NEAR_PLANE));
+	bucket = CLAMP(bucket, 0, QUEUE_DEPTH_BUCKETS - 1);
 
-			sysLog << "uv0='" <<
-				obj->verts[obj->faces[index].a].texCoord.u << "," <<
-				obj->verts[obj->faces[index].a].texCoord.v <<"'\n";
-			sysLog << "uv1='" <<
-				obj->verts[obj->faces[index].b].texCoord.u << "," <<
-				obj->verts[obj->faces[index].b].texCoord.v <<"'\n";
-			sysLog << "uv2='" <<
-				obj->verts[obj->faces[index].c].texCoord.u << "," <<
-				obj->verts[obj->faces[index].c].texCoord.v <<"'\n";
+	if(hsrMode == HSR_PAINTER)
+	{
+		item.key[0] = QUEUE_DEPTH_BUCKETS - 1 - bucket;
+		item.key[1] = obj->textureID;
+	}
+	else
+	{
+		item.key[0] = obj->textureID;
+		item.key[1] = bucket;
+	}
+	item.key[2] = (int)queue.size();
+
+	queue.push_back(item);
+}
+
+static bool compareQueueItems(const QueueItem &a, const QueueItem &b)
+{
+	for(int i = 0; i < 3; i++)
+	{
+		if(a.key[i] != b.key[i])
+			return a.key[i] < b.key[i];
+	}
+	return false;
+}
+
+/* Transform the vertices of the specified object and store the indices of
+	its visible faces in visible. Returns their number. */
+int Renderer::visibleFaces(Object *obj, int cull, int *visible)
+{
+	int numVisible=0;
+
+	// Transform and project every vertex once
+	transformVertices(obj, cull != CULL_INSIDE);
+
+	// Reject the faces outside the frustum or culled before any other work
+	for(int i = 0; i < obj->numFaces; i++)
+	{
+		if(isFaceVisible(obj, i))
+		{
+			visible[numVisible] = i;
+			numVisible++;
+		}
+	}
+
+	stats.numFacesTested += obj->numFaces;
+	stats.numFacesCulled += obj->numFaces - numVisible;
+	stats.numFaces += numVisible;
+	return numVisible;
+}
+
+/* Render the submitted objects in the order of their keys. The painter's
+	algorithm and the span buffer need the faces in depth order : the faces
+	of all the objects are then sorted together. */
+void Renderer::flushQueue(void)
+{
+	if(queue.empty())
+		return;
+
+	std::sort(queue.begin(), queue.end(), compareQueueItems);
+
+	if(hsrMode != HSR_ZBUFFER)
+	{
+		flushSortedFaces();
+		queue.clear();
+		return;
+	}
+
+	Mat4x3 mat = matWorld;
+	for(size_t i = 0; i < queue.size(); i++)
+	{
+		matWorld = queue[i].matWorld;
+		bindTexture(queue[i].obj->textureID);
+		renderObject(queue[i].obj, queue[i].cull);
+	}
+	matWorld = mat;
+
+	queue.clear();
+}
+
+/* Collect the visible faces of the queued objects, with a copy of the
+	transformed vertices they use, sort them once and render them. Overlapping objects
+	are then drawn in the right order, not in the order of the queue. */
+void Renderer::flushSortedFaces(void)
+{
+	int maxVerts = 0, maxFaces = 0, maxObjectVerts = 0;
+	for(size_t i = 0; i < queue.size(); i++)
+	{
+		const Object *obj = queue[i].obj;
+		maxVerts += obj->numVerts < 3 * obj->numFaces ? obj->numVerts : 3 * obj->numFaces;
+		maxFaces += obj->numFaces;
+		if(obj->numVerts > maxObjectVerts)
+			maxObjectVerts = obj->numVerts;
+	}
+
+	// The buffers live until the end of the frame, frameVerts only grows
+	if(maxVerts > frameVerts.stride)
+		frameVerts.Alloc(maxVerts);
+	FrameFace *frameFaces = frameArena.Alloc<FrameFace>(maxFaces);
+	int* visible = frameArena.Alloc<int>(maxFaces);
+	int numVerts = 0, num = 0;
+
+	// Index in frameVerts of the vertices of the current object, -1 if not copied
+	int* remap = frameArena.Alloc<int>(maxObjectVerts);
+	for(int j = 0; j < maxObjectVerts; j++)
+		remap[j] = -1;
+
+	Mat4x3 mat = matWorld;
+	for(size_t i = 0; i < queue.size(); i++)
+	{
+		Object *obj = queue[i].obj;
+		matWorld = queue[i].matWorld;
+
+		int numVisible=visibleFaces(obj, queue[i].cull, visible);
+
+		/* An object may be submitted several times, its vertices are copied.
+			Only the ones used by the visible faces are. */
+		for(int j = 0; j < numVisible; j++)
+		{
+			const Triangle &face = obj->faces[visible[j]];
+			FrameFace f;
+			f.verts[0] = copyVertex(obj, face.a, remap, &numVerts);
+			f.verts[1] = copyVertex(obj, face.b, remap, &numVerts);
+			f.verts[2] = copyVertex(obj, face.c, remap, &numVerts);
+			f.cenZ = (obj->arrays.wz[face.a] +
+						 obj->arrays.wz[face.b] +
+						 obj->arrays.wz[face.c]) / 3;
+			f.textureID = obj->textureID;
+			f.index = visible[j];
+			frameFaces[num++] = f;
+		}
+
+		// Ready for the next object
+		for(int j = 0; j < numVisible; j++)
+		{
+			const Triangle &face = obj->faces[visible[j]];
+			remap[face.a] = remap[face.b] = remap[face.c] = -1;
+		}
+	}
+	matWorld = mat;
+
+	if(num == 0)
+		return;
+
+	/* The coherent sorter starts from the order of the previous frame, as
+		long as the scene has the same number of visible faces */
+	if(depthSorter.GetMode() != DepthSorter::COHERENT || (int)frameOrder.size() != num)
+	{
+		frameOrder.resize(num);
+		for(int i = 0; i < num; i++)
+			frameOrder[i] = i;
+	}
+	depthSorter.Sort(&frameFaces[0].cenZ, sizeof(FrameFace), &frameOrder[0], num);
+
+	// The span buffer is filled from front to back
+	for(int i = 0; i < num; i++)
+	{
+		const FrameFace &f = frameFaces[frameOrder[hsrMode == HSR_SBUFFER ? num-1-i : i]];
+		bindTexture(f.textureID);
+		rasterizeFace(frameVerts, f.verts[0], f.verts[1], f.verts[2], f.index);
+	}
+}
+
+/* Index in frameVerts of the vertex index of obj, copied at *numVerts the
+	first time it is asked for */
+int Renderer::copyVertex(const Object *obj, int index, int *remap, int *numVerts)
+{
+	if(remap[index] < 0)
+	{
+		remap[index] = *numVerts;
+		frameVerts.CopyRaster((*numVerts)++, obj->arrays, index);
+	}
+	return remap[index];
+}
+
+/* Make the texture textureID current. The faces are rasterized with the
+	palette of their texture (Texture::palette), nothing else is bound. */
+void Renderer::bindTexture(int textureID)
+{
+	Texture *texture = TextureManager::Instance().GetTexture(textureID);
+	if(texture == currentTexture)
+		return;
+
+	currentTexture = texture;
+	stats.numTextureSwitches++;
+}
+
+/* Render the specified object with the current texture. cull is the result
+	of cullObject. */
+void Renderer::renderObject(Object *obj, int cull)
+{
+	// Loop through the tris and transform their vertices
+	int a,b,c;
+	size_t mark = frameArena.GetMark();
+	int* visible=frameArena.Alloc<int>(obj->numFaces);
+	int numVisible=visibleFaces(obj, cull, visible);
+
+	/* The coherent sorter starts from the order of the previous frame, kept in
+		obj->visible for all the faces, so it needs the centroid of every face.
+		The visible faces are then picked in that order. */
+	bool coherent = depthSorter.GetMode() == DepthSorter::COHERENT;
+	int numCentroids = coherent ? obj->numFaces : numVisible;
+
+	for(int i = 0; i < numCentroids; i++)
+	{
+		Triangle *face = &obj->faces[coherent ? i : visible[i]];
+		a=face->a;
+		b=face->b;
+		c=face->c;
+
+		face->cenZ = (obj->arrays.wz[a] + 
+						  obj->arrays.wz[b] + 
+						  obj->arrays.wz[c])	/ 3;
+	}
+
+	if(coherent)
+	{
+		if(!obj->visible)
+		{
+			obj->visible=new int[obj->numFaces];
+			for(int i = 0; i < obj->numFaces; i++)
+				obj->visible[i]=i;
+		}
+		depthSorter.Sort(obj->faces, obj->visible, obj->numFaces);
+
+		numVisible=0;
+		for(int i = 0; i < obj->numFaces; i++)
+		{
+			int index = obj->visible[i];
+			if(isFaceVisible(obj, index))
+			{
+				visible[numVisible] = index;
+				numVisible++;
+			}
+		}
+	}
+	// Sort the visible faces from back to front (useless with a depth buffer)
+	else if(hsrMode != HSR_ZBUFFER)
+		depthSorter.Sort(obj->faces, visible, numVisible);
+
+	// Render
+	const VertexArrays &v = obj->arrays;
+	for(int i = 0; i < numVisible; i++)
+	{
+		// The span buffer is filled from front to back
+		Triangle *face = &obj->faces[visible[hsrMode == HSR_SBUFFER ? numVisible-1-i : i]];
+		rasterizeFace(v, face->a, face->b, face->c, (int)(face - obj->faces));
+	}
+	frameArena.Rewind(mark);
+}
+
+/* Test the bounding volumes of the specified object against the view
+	frustum : first the sphere, which is cheap, then the corners of the box
+	if the sphere intersects a plane. The world matrix is assumed rigid (no
+	scaling), so the radius of the sphere doesn't change. depth is set to the
+	view space depth of the object. */
+int Renderer::cullObject(const Object* obj, float *depth) const
+{
+	const Bounds &bounds = obj->bounds;
+	if(bounds.radius < 0)
+	{
+		*depth = (obj->body.pos * matWorld).z;
+		return CULL_INTERSECT;
+	}
+
+	Vector3 c = (obj->body.pos + bounds.center) * matWorld;
+	float r = bounds.radius;
+	*depth = c.z;
+
+	// Distances to the planes, see clipCode for their equations
+	float w = halfVpW + 1, h = halfVpH + 1;
+	float invW = 1.0f / sqrt((float)FOCAL*FOCAL + w*w);
+	float invH = 1.0f / sqrt((float)FOCAL*FOCAL + h*h);
+	float dist[6];
+	dist[0] = c.z - NEAR_PLANE;
+	dist[1] = FAR_PLANE - c.z;
+	dist[2] = ( c.x*FOCAL + w*c.z) * invW;
+	dist[3] = (-c.x*FOCAL + w*c.z) * invW;
+	dist[4] = (-c.y*FOCAL + h*c.z) * invH;
+	dist[5] = ( c.y*FOCAL + h*c.z) * invH;
+
+	bool inside = true;
+	for(int i = 0; i < 6; i++)
+	{
+		if(dist[i] < -r)
+			return CULL_OUTSIDE;
+		if(dist[i] < r)
+			inside = false;
+	}
+	if(inside)
+		return CULL_INSIDE;
+
+	// The box is outside if its 8 corners are outside of the same plane
+	int codeAnd = ~0, codeOr = 0;
+	for(int i = 0; i < 8; i++)
+	{
+		Vector3 p((i & 1) ? bounds.max.x : bounds.min.x,
+					 (i & 2) ? bounds.max.y : bounds.min.y,
+					 (i & 4) ? bounds.max.z : bounds.min.z);
+		int code = clipCode((obj->body.pos + p) * matWorld);
+		codeAnd &= code;
+		codeOr |= code;
+	}
+	if(codeAnd)
+		return CULL_OUTSIDE;
+	if(!codeOr)
+		return CULL_INSIDE;
+	return CULL_INTERSECT;
+}
+
+/* Transform the vertices of the specified object in world space and project
+	them on the screen. Each vertex is processed once, no matter how many faces
+	share it, so the face setup only has to read wz, sx and sy. If clip
+	is false the object is inside the view frustum and the clip codes are not
+	computed. */
+void Renderer::transformVertices(Object* obj, bool clip)
+{
+	VertexArrays &v = obj->arrays;
+
+	// The position of the object is added to the translation of the matrix
+	Mat4x3 m = matWorld;
+	Vector3 pos = obj->body.pos * matWorld;
+	m._41 = pos.x;
+	m._42 = pos.y;
+	m._43 = pos.z;
+
+#ifdef FIXED_PIPELINE
+	if(fixedPipeline)
+	{
+		transformVerticesFixed(v, m, clip);
+		return;
+	}
+#endif
+
+	m.transformPoints(v.x, v.y, v.z, v.wx, v.wy, v.wz, v.numVerts);
+
+	for(int i = 0; i < v.numVerts; i++)
+	{
+		float wx = v.wx[i], wy = v.wy[i], wz = v.wz[i];
+		int code = clip ? clipCode(wx, wy, wz) : 0;
+		v.clip[i] = code;
+
+		// Behind the near plane, only the clipped faces are projected
+		if(!(code & CLIP_NEAR))
+		{
+			float inv = ((float)FOCAL / wz);
+			v.sx[i] = wx * inv + halfVpW + vp[0];
+			v.sy[i] = -wy * inv + halfVpH + vp[1];
+		}
+	}
+}
+
+#ifdef FIXED_PIPELINE
+/* Same as transformVertices in 16.16 fixed point. The matrix m is converted
+	from float once per object, then the transform, the clip codes and the
+	projection only use integers (one 64 bit divide per projected vertex).
+	So do the near clipping (clipEdgeFixed), the triangle ordering, the edges
+	and the texel interpolation of setupFace.
+	The face culling, the depth sort, the mip selection, the half-space core
+	and the depth and texture planes stay float : they read wx, wy, wz, sx and
+	sy, converted from the fixed results and never converted back. */
+void Renderer::transformVerticesFixed(VertexArrays &v, const Mat4x3 &m, bool clip)
+{
+	Mat4x3x mx(m);
+
+	for(int i = 0; i < v.numVerts; i++)
+	{
+		FixedWide x = v.fx[i], y = v.fy[i], z = v.fz[i];
+		int wx = (int)((x * mx._11.raw + y * mx._21.raw + z * mx._31.raw) >> 16) + mx._41.raw;
+		int wy = (int)((x * mx._12.raw + y * mx._22.raw + z * mx._32.raw) >> 16) + mx._42.raw;
+		int wz = (int)((x * mx._13.raw + y * mx._23.raw + z * mx._33.raw) >> 16) + mx._43.raw;
+		int code = clip ? clipCodeFixed(wx, wy, wz) : 0;
+		v.clip[i] = code;
+
+		v.fwx[i] = wx;
+		v.fwy[i] = wy;
+		v.fwz[i] = wz;
+		v.wx[i] = Fixed16::FromRaw(wx).ToFloat();
+		v.wy[i] = Fixed16::FromRaw(wy).ToFloat();
+		v.wz[i] = Fixed16::FromRaw(wz).ToFloat();
+
+		if(!(code & CLIP_NEAR))
+			projectFixedVertex(v, i);
+	}
+}
+#endif
+
+/* Create the vertex n of v where the edge from a to b crosses the near plane,
+	and project it */
+void Renderer::clipEdge(VertexArrays &v, int a, int b, int n)
+{
+	float t = (NEAR_PLANE - v.wz[a]) / (v.wz[b] - v.wz[a]);
+
+	v.wx[n] = v.wx[a] + (v.wx[b] - v.wx[a]) * t;
+	v.wy[n] = v.wy[a] + (v.wy[b] - v.wy[a]) * t;
+	v.wz[n] = NEAR_PLANE;
+	v.u[n] = v.u[a] + (v.u[b] - v.u[a]) * t;
+	v.v[n] = v.v[a] + (v.v[b] - v.v[a]) * t;
+	v.clip[n] = clipCode(v.wx[n], v.wy[n], v.wz[n]) & ~CLIP_NEAR;
+	project(v, n);
+}
+
+#ifdef FIXED_PIPELINE
+// Value at t (16.16) of the way from a to b
+static inline int lerpFixed(int a, int b, FixedWide t)
+{
+	return a + (int)((((FixedWide)b - a) * t) >> 16);
+}
+
+/* Same as clipEdge on the 16.16 world and texture coordinates. The floats
+	are only written for the float stages (see transformVerticesFixed) */
+void Renderer::clipEdgeFixed(VertexArrays &v, int a, int b, int n)
+{
+	// The edge crosses the plane, fwz[b] != fwz[a]
+	FixedWide t = ((FixedWide)(NEAR_PLANE_FIXED - v.fwz[a]) << 16) / ((FixedWide)v.fwz[b] - v.fwz[a]);
+
+	v.fwx[n] = lerpFixed(v.fwx[a], v.fwx[b], t);
+	v.fwy[n] = lerpFixed(v.fwy[a], v.fwy[b], t);
+	v.fwz[n] = NEAR_PLANE_FIXED;
+	v.fu[n] = lerpFixed(v.fu[a], v.fu[b], t);
+	v.fv[n] = lerpFixed(v.fv[a], v.fv[b], t);
+	v.clip[n] = clipCodeFixed(v.fwx[n], v.fwy[n], v.fwz[n]) & ~CLIP_NEAR;
+	projectFixedVertex(v, n);
+
+	v.wx[n] = Fixed16::FromRaw(v.fwx[n]).ToFloat();
+	v.wy[n] = Fixed16::FromRaw(v.fwy[n]).ToFloat();
+	v.wz[n] = Fixed16::FromRaw(v.fwz[n]).ToFloat();
+	v.u[n] = Fixed16::FromRaw(v.fu[n]).ToFloat();
+	v.v[n] = Fixed16::FromRaw(v.fv[n]).ToFloat();
+}
+#endif
+
+/* Sutherland-Hodgman clipping of the triangle idx of verts against the near
+	plane. The other planes don't need clipping : the rasterizers clip to the
+	screen and the half-space core falls back to the scanline core outside its
+	guard band. The triangle is copied in clipVerts, followed by the vertices
+	created. Returns the number of vertices of the clipped polygon poly (0, 3
+	or 4), indices in clipVerts. */
+int Renderer::clipNear(const VertexArrays &verts, const int *idx, int *poly)
+{
+	VertexArrays &v = clipVerts;
+	int num = 0, numNew = 3;
+
+	for(int i = 0; i < 3; i++)
+		v.CopyRaster(i, verts, idx[i]);
+
+	for(int a = 0; a < 3; a++)
+	{
+		int b = a == 2 ? 0 : a + 1;
+		bool aIn = !(v.clip[a] & CLIP_NEAR);
+		bool bIn = !(v.clip[b] & CLIP_NEAR);
+
+		if(aIn)
+			poly[num++] = a;
+
+		// The edge crosses the plane
+		if(aIn != bIn)
+		{
+			int n = numNew++;
+#ifdef FIXED_PIPELINE
+			if(fixedPipeline)
+				clipEdgeFixed(v, a, b, n);
+			else
+#endif
+				clipEdge(v, a, b, n);
+			poly[num++] = n;
+		}
+	}
+	return num;
+}
+
+/* Rasterize the index-th face of the specified object
+	Vertices have to be specified using the following system coordinates.
+	They also have to be ordered in a clockwize direction.
+	^ +y
+	|
+	|
+	|	
+	(0,0)-----> +x
+	/
+  /
+  +z
+
+  System coordinate used for texture mapping
+	^ -v
+	|
+	|
+	|		
+  (0,0)-----> +u
+  */
+void Renderer::rasterizeFace(const VertexArrays &verts, int a, int b, int c, int index)
+{
+	int idx[3];
+	idx[0] = a;
+	idx[1] = b;
+	idx[2] = c;
+
+	if(!((verts.clip[a] | verts.clip[b] | verts.clip[c]) & CLIP_NEAR))
+	{
+		rasterizeTriangle(verts, idx, index);
+		return;
+	}
+
+	// Crosses the near plane : render the clipped polygon as a fan
+	int poly[4];
+	int num = clipNear(verts, idx, poly);
+	for(int i = 1; i + 1 < num; i++)
+	{
+		idx[0] = poly[0];
+		idx[1] = poly[i];
+		idx[2] = poly[i + 1];
+		rasterizeTriangle(clipVerts, idx, index);
+	}
+}
+
+/* Rasterize the projected triangle idx of verts. index is the face it comes
+	from, for the logs. */
+void Renderer::rasterizeTriangle(const VertexArrays &verts, const int *idx, int index)
+{
+	RasterFace face;
+
+	faceTexture = selectMipmap(verts, idx);
+
+	// The span buffer needs spans, it always uses the scanline core
+	if(rasterCore == RASTER_HALFSPACE && hsrMode != HSR_SBUFFER)
+	{
+		if(!setupHalfSpace(verts, idx, index, &face))
+			return;
+	}
+	else
+	{
+		if(!setupFace(verts, idx, index, &face))
+			return;
+	}
+
+	const HSpan *rows = NULL;
+	if(face.core == RASTER_SCANLINE)
+		rows = &spans[face.minY];
+
+	// Rasterized later, tile by tile
+	if(binner->GetNumThreads() > 0 && hsrMode != HSR_SBUFFER)
+	{
+		binner->AddFace(face, rows);
+		return;
+	}
+
+	rasterizeRect(&face, rows, 0, 0, SCR_WIDTH - 1, SCR_HEIGHT - 1);
+}
+
+/* Render the part of a face inside the rectangle [cx1,cx2]x[cy1,cy2] with
+	the core which set it up. rows is only used by the scanline core. */
+void Renderer::rasterizeRect(const RasterFace* face, const HSpan* rows,
+									  long cx1, long cy1, long cx2, long cy2)
+{
+	if(face->core == RASTER_HALFSPACE)
+		rasterizeBlocks(face, cx1, cy1, cx2, cy2);
+	else
+		rasterizeSpans(face, rows, cx1, cy1, cx2, cy2);
+}
+
+/* Cross product of (ax,ay) and (bx,by) on whole pixels (Vector2), from the
+	float or the 16.16 coordinates */
+static inline int cross2(float ax, float ay, float bx, float by)
+{
+	Vector2 vAB, vAC;
+	vAB.x = ax;
+	vAB.y = ay;
+	vAC.x = bx;
+	vAC.y = by;
+	return vAB.x*vAC.y - vAB.y*vAC.x;
+}
+
+static inline int cross2(int ax, int ay, int bx, int by)
+{
+	Vector2 vAB, vAC;
+	vAB.x = ax / 65536;
+	vAB.y = ay / 65536;
+	vAC.x = bx / 65536;
+	vAC.y = by / 65536;
+	return vAB.x*vAC.y - vAB.y*vAC.x;
+}
+
+/* Order the triangle of screen coordinates x, y for the texel interpolation :
+	returns its type and finds the vertex UVIndex0 its edges start from, the
+	vertex in the middle in y of a GENERAL triangle (-1 otherwise) and the 2
+	other vertices, on the left and on the right. T is float, or int for the
+	16.16 coordinates of the fixed pipeline which are compared as they are. */
+template <class T>
+static TRIANGLE_TYPE orderTriangle(const T *x, const T *y, int *UVIndex0, int *indexMiddle,
+											  int *left, int *right)
+{
+	TRIANGLE_TYPE type = GENERAL;
+	*UVIndex0 = -1;
+	*indexMiddle = -1;
+	for(int i=0;(i<3) && (*UVIndex0==-1);i++)
+	{
+		for(int j=0;j<3;j++)
+		{
+			if(j==i) continue;
+			if(y[i] == y[j])
+			{
+				if(y[i] > y[3-i-j])
+				{
+					type=FLAT_TOP; // 2 upper y-coordinates
+					*UVIndex0 = 3-i-j;
+				}
+				else
+				{
+					type=FLAT_BOTTOM; // 2 lower y-coordinates
+
+					if(x[i] < x[j])
+						*UVIndex0 = i;
+					else
+						*UVIndex0 = j;
+				}
+				break;
+			}
+			else
+			if(y[i] < y[j])
+			{
+				if(y[j] < y[3-i-j])
+				{
+					// GENERAL triangle
+					*UVIndex0=i;
+					*indexMiddle=j;
+					break;
+				}
+			}
+		}
+	}
+
+	/* Vertices are ordered in a clockwize manner (before and after projection)
+		sUVIndex points to the pixel having the lowest x and y coordinates
+		In consequence, the next pixel (sUVIndex+1) is on the right and the one
+		after is on the left */
+	int a = *UVIndex0, l = a+1, r;
+	if(l>2) l=0;
+	r = l+1;
+	if(r>2) r=0;
+
+	if(cross2(x[a] - x[l], y[a] - y[l], x[r] - x[l], y[r] - y[l]) < 0)
+	{
+		*left = r;
+		*right = l;
+	}
+	else
+	{
+		*left = l;
+		*right = r;
+	}
+	return type;
+}
+
+/* Scan-convert the triangle idx of verts into spans[] and fill face with everything
+	needed to render the spans. Returns false if the face doesn't cover any
+	scanline. */
+bool Renderer::setupFace(const VertexArrays &verts, const int *idx, int index, RasterFace* face)
+{
+	// Init span information
+	minY = 10000;
+	maxY = -10000;
+
+	/* scanEdge only writes the scanlines covered by the triangle, reset
+		those ones (rounded and clipped the same way) */
+	long top = MIN(screenRow(verts, idx[0]), MIN(screenRow(verts, idx[1]), screenRow(verts, idx[2])));
+	long bottom = MAX(screenRow(verts, idx[0]), MAX(screenRow(verts, idx[1]), screenRow(verts, idx[2])));
+	long first = MAX(top, 0);
+	long last = MIN(bottom, SCR_HEIGHT - 1);
+
+	// BenchmarkSetup : all of them, as setupFace used to
+	if(resetAllSpans)
+	{
+		first = 0;
+		last = SCR_HEIGHT - 1;
+	}
+
+	for(long i = first; i <= last; i++)
+	{
+		spans[i].xStart = minY;
+		spans[i].xEnd = maxY;
+	}
+
+	// Scan-convert the triangle
+	scanEdge(verts, idx[0], idx[1]);
+	scanEdge(verts, idx[1], idx[2]);
+	scanEdge(verts, idx[2], idx[0]);	
+
+	if(minY >= maxY)
+		return false;
+
+	if(hsrMode != HSR_PAINTER)
+		calcDepthPlane(verts, idx, face);
+	else
+		face->depthA = face->depthB = face->depthC = 0;
+
+	// Looking for the point having texture coord (u,v)=(0,0)
+	int UVIndex0, indexMiddle;
+	TRIANGLE_TYPE triangle_type;
+#ifdef FIXED_PIPELINE
+	if(fixedPipeline)
+	{
+		int x[3], y[3];
+		for(int i = 0; i < 3; i++)
+		{
+			x[i] = verts.fsx[idx[i]];
+			y[i] = verts.fsy[idx[i]];
+		}
+		triangle_type = orderTriangle(x, y, &UVIndex0, &indexMiddle, &iLeft, &iRight);
+	}
+	else
+#endif
+	{
+		float x[3], y[3];
+		for(int i = 0; i < 3; i++)
+		{
+			x[i] = verts.sx[idx[i]];
+			y[i] = verts.sy[idx[i]];
+		}
+		triangle_type = orderTriangle(x, y, &UVIndex0, &indexMiddle, &iLeft, &iRight);
+	}
+
+#ifdef DEBUG
+	int cptError=0;
+#endif //DEBUG
+
+	/* Objects without texture (textureID -1) are drawn flat, their spans
+		only need to be clipped */
+#ifdef FIXED_PIPELINE
+	if(faceTexture && fixedPipeline)
+		interpolateTexelsFixed(verts, idx, triangle_type, UVIndex0, indexMiddle);
+	else
+#endif
+	if(faceTexture)
+		interpolateTexels(verts, idx, triangle_type, UVIndex0, indexMiddle);
+	else
+	{
+		for(int i = minY; i < maxY; i++)
+			clipSpan(&spans[i]);
+	}
+
+	// The spans only hold affine texel coordinates
+	if(perspectiveSpan)
+		calcTexturePlanes(verts, idx, face);
+	else
+		face->perspective = 0;
+
+	face->core = RASTER_SCANLINE;
+	face->minY = minY;
+	face->maxY = maxY;
+	face->texture = faceTexture;
+	face->mode = Application::Instance().RenderingMode;
+	if(!faceTexture)
+		face->mode &= ~Application::TEXTURED;
+
+#ifdef DEBUG_MODE
+	if(cptError>10)
+	{
+		std::list<int>::iterator where = std::find(listErrorFaces.begin(), listErrorFaces.end(), index);
+		if(where == listErrorFaces.end())
+		{
+			listErrorFaces.push_back(index);
+			sysLog << "cptError: " << cptError <<"\n";
+			sysLog << "Rotation: " << Application::Instance().GetRotation()<<"\n";
+			sysLog << "index: " << index <<"\n";
+			sysLog << "triangle_type: " << triangle_type <<"\n";			
+
+			int i0 = idx[0], i1 = idx[1], i2 = idx[2];
+			Vector3 vAB(verts.wx[i1] - verts.wx[i0], verts.wy[i1] - verts.wy[i0], verts.wz[i1] - verts.wz[i0]);
+			Vector3 vAC(verts.wx[i2] - verts.wx[i0], verts.wy[i2] - verts.wy[i0], verts.wz[i2] - verts.wz[i0]);
+			float fNorm = vAB.x*vAC.y - vAB.y*vAC.x;
+			sysLog << "vA=[" <<
+				verts.sx[idx[0]] << " " <<
+				verts.sy[idx[0]] <<"]\n";
+			sysLog << "vB=[" <<
+				verts.sx[idx[1]] << " " <<
+				verts.sy[idx[1]] <<"]\n";
+			sysLog << "vC=[" <<
+				verts.sx[idx[2]] << " " <<
+				verts.sy[idx[2]] <<"]\n";			
+
+			float UVNorm = (u1 - u0)*(v2 - v0) - (v1 - v0)*(u2 - u0);
+
+			sysLog << "uv0='" <<
+				verts.u[idx[0]] << "," <<
+				verts.v[idx[0]] <<"'\n";
+			sysLog << "uv1='" <<
+				verts.u[idx[1]] << "," <<
+				verts.v[idx[1]] <<"'\n";
+			sysLog << "uv2='" <<
+				verts.u[idx[2]] << "," <<
+				verts.v[idx[2]] <<"'\n";
 
 			sysLog << "Face normal: " << fNorm <<"\n";
 			sysLog << "UV normal: " << UVNorm <<"\n";
 
-			sysLog << "-------------------------\n";
+			sysLog << "-------------------------\n";
+		}
+	}
+#endif //DEBUG
+	return true;
+}
+
+#ifdef FIXED_PIPELINE
+// Texel step for one scanline, delta over dy (both in 16.16)
+static inline long texelStep(long delta, long dy)
+{
+	return dy > 0 ? (long)(((FixedWide)delta << 16) / dy) : 0;
+}
+
+/* Interpolate the texel coordinates along the left and right edges of the
+	face set up by setupFace, and store them at both ends of its spans. Same
+	as the float version, in 16.16 fixed point : the divisions are done once
+	per edge and the scanlines only add the steps. */
+void Renderer::interpolateTexelsFixed(const VertexArrays &verts, const int *idx, int triangleType, int UVIndex0, int indexMiddle)
+{
+	int ia = idx[UVIndex0], il = idx[iLeft], ir = idx[iRight];
+	long width = faceTexture->width, height = faceTexture->height;
+
+	long tu0 = verts.fu[ia] * width, tv0 = verts.fv[ia] * height;
+	long tu1 = verts.fu[il] * width, tv1 = verts.fv[il] * height;
+	long tu2 = verts.fu[ir] * width, tv2 = verts.fv[ir] * height;
+
+	long uL = tu0, vL = tv0, uR = tu0, vR = tv0;
+	long duL, dvL, duR, dvR;
+	long rows = lowestRow(verts, idx) - minY;
+
+	if(triangleType == FLAT_TOP)
+	{
+		duL = (tu1 - tu0) / rows;
+		dvL = (tv1 - tv0) / rows;
+		duR = (tu2 - tu0) / rows;
+		dvR = (tv2 - tv0) / rows;
+	}
+	else
+	if(triangleType == FLAT_BOTTOM)
+	{
+		duL = (tu1 - tu0) / rows;
+		dvL = (tv1 - tv0) / rows;
+		duR = (tu1 - tu2) / rows;
+		dvR = (tv1 - tv2) / rows;
+		uR = tu2;
+		vR = tv2;
+	}
+	else
+	{
+		// GENERAL
+		long top = minY << 16;
+		duL = texelStep(tu1 - tu0, verts.fsy[il] - top);
+		dvL = texelStep(tv1 - tv0, verts.fsy[il] - top);
+		duR = texelStep(tu2 - tu0, verts.fsy[ir] - top);
+		dvR = texelStep(tv2 - tv0, verts.fsy[ir] - top);
+	}
+
+	if(indexMiddle != -1)
+		yMiddle = screenRow(verts, idx[indexMiddle]);
+	else
+		yMiddle = maxY;
+
+	for(int i = minY; i < maxY; i++)
+	{
+		if(i == yMiddle)
+		{
+			long dy = (maxY << 16) - verts.fsy[idx[indexMiddle]];
+			if(indexMiddle == iLeft)
+			{
+				// Change left side, going from left to right
+				uL = tu1;
+				vL = tv1;
+				duL = texelStep(tu2 - tu1, dy);
+				dvL = texelStep(tv2 - tv1, dy);
+			}
+			else
+			{
+				// Change right side, going from right to left
+				uR = tu2;
+				vR = tv2;
+				duR = texelStep(tu1 - tu2, dy);
+				dvR = texelStep(tv1 - tv2, dy);
+			}
+		}
+
+		HSpan *span = &spans[i];
+		if(clipSpan(span))
+		{
+			span->uStart = uL;
+			span->vStart = vL;
+			span->uEnd = uR;
+			span->vEnd = vR;
+		}
+
+		uL += duL;
+		vL += dvL;
+		uR += duR;
+		vR += dvR;
+	}
+}
+#endif
+
+/* Interpolate the texel coordinates along the left and right edges of the
+	face set up by setupFace, and store them at both ends of its spans */
+void Renderer::interpolateTexels(const VertexArrays &verts, const int *idx, int triangleType, int UVIndex0, int indexMiddle)
+{
+	/* Initialize the 3 texture coordinates for the 3 vertices of the specified
+		triangle.
+		Important : Vertices are ordered in a clockwize manner (before and after
+		projection)
+		*/
+	u0=verts.u[idx[UVIndex0]]*faceTexture->width;
+	v0=verts.v[idx[UVIndex0]]*faceTexture->height;
+
+	u1=verts.u[idx[iLeft]]*faceTexture->width;
+	v1=verts.v[idx[iLeft]]*faceTexture->height;
+
+	u2=verts.u[idx[iRight]]*faceTexture->width;
+	v2=verts.v[idx[iRight]]*faceTexture->height;
+
+	// The edges of a flat triangle end on its lowest row, maxY is clipped
+	diffY=1.0/(lowestRow(verts, idx)-minY);
+
+	if(triangleType == FLAT_TOP)
+	{
+		ul=u0;
+		vl=v0;
+		ur=u0;
+		vr=v0;
+
+		if(faceTexture)
+		{
+			dudyl=(float)(u1-u0)*diffY;
+			dvdyl=(float)(v1-v0)*diffY;
+			dudyr=(float)(u2-u0)*diffY;
+			dvdyr=(float)(v2-v0)*diffY;
+		}
+	}
+	else
+	if(triangleType == FLAT_BOTTOM)
+	{
+		if(faceTexture)
+		{
+			dudyl=(float)(u1-u0)*diffY;
+			dvdyl=(float)(v1-v0)*diffY;
+			dudyr=(float)(u1-u2)*diffY;
+			dvdyr=(float)(v1-v2)*diffY;
+		}
+
+		ul=u0;
+		vl=v0;
+		ur=u2;
+		vr=v2;
+	}
+	else
+	{
+		// GENERAL
+		ul=u0;
+		vl=v0;
+		ur=u0;
+		vr=v0;
+
+		if(faceTexture)
+		{
+			dudyl=(float)(verts.u[idx[iLeft]]-verts.u[idx[UVIndex0]])*faceTexture->width/(verts.sy[idx[iLeft]]-minY);
+			dvdyl=(float)(verts.v[idx[iLeft]]-verts.v[idx[UVIndex0]])*faceTexture->height/(verts.sy[idx[iLeft]]-minY);
+			dudyr=(float)(verts.u[idx[iRight]]-verts.u[idx[UVIndex0]])*faceTexture->width/(verts.sy[idx[iRight]]-minY);
+			dvdyr=(float)(verts.v[idx[iRight]]-verts.v[idx[UVIndex0]])*faceTexture->height/(verts.sy[idx[iRight]]-minY);
 		}
 	}
-#endif //DEBUG
+
+	// Update yMiddle
+	if(indexMiddle != -1)
+		yMiddle = verts.sy[idx[indexMiddle]];
+	else
+		yMiddle = maxY;
+
+	for(int i = minY; i < maxY; i++)
+	{
+		if(i == yMiddle)
+		{
+			if(indexMiddle == iLeft)
+			{
+				// Change left side
+				ul=verts.u[idx[iLeft]]*faceTexture->width;
+				vl=verts.v[idx[iLeft]]*faceTexture->height;
+				// Going from left to right
+				dudyl=(float)(verts.u[idx[iRight]]-verts.u[idx[iLeft]])*faceTexture->width/(maxY-verts.sy[idx[indexMiddle]]);
+				dvdyl=(float)(verts.v[idx[iRight]]-verts.v[idx[iLeft]])*faceTexture->height/(maxY-verts.sy[idx[indexMiddle]]);
+			}
+			else
+			{
+				// Change right side
+				ur=verts.u[idx[iRight]]*faceTexture->width;
+				vr=verts.v[idx[iRight]]*faceTexture->height;
+				// Going from right to left
+				dudyr=(float)(verts.u[idx[iLeft]]-verts.u[idx[iRight]])*faceTexture->width/(maxY-verts.sy[idx[indexMiddle]]);
+				dvdyr=(float)(verts.v[idx[iLeft]]-verts.v[idx[iRight]])*faceTexture->height/(maxY-verts.sy[idx[indexMiddle]]);
+			}
+		}
+
+		HSpan *span = &spans[i];
+
+		// Texture coordinates at both ends of the span (16.16 fixed point)
+		if(clipSpan(span))
+		{
+			span->uStart = (long)(ul * 65536.0f);
+			span->vStart = (long)(vl * 65536.0f);
+			span->uEnd = (long)(ur * 65536.0f);
+			span->vEnd = (long)(vr * 65536.0f);
+		}
+
+		//interploate u,v along right and left side
+		ul+=dudyl;
+		vl+=dvdyl;
+
+		ur+=dudyr;
+		vr+=dvdyr;
+	}
+}
+
+/* Set up the triangle idx of verts for the half-space core.
+	The vertices are snapped to 28.4 fixed point and each edge is described by
+	an integer edge function E(x,y) = A*x + B*y + C, positive inside the face.
+	Pixels are sampled at their center, and pixels lying exactly on an edge
+	belong to the face only if the edge is a top or a left edge, so faces
+	sharing an edge never overlap nor leave gaps. Returns false if the face
+	doesn't cover any pixel. */
+bool Renderer::setupHalfSpace(const VertexArrays &verts, const int *idx, int index, RasterFace* face)
+{
+	long x[3], y[3];
+	for(int i = 0; i < 3; i++)
+	{
+		// Outside the guard band, the edge functions could overflow
+		if(verts.sx[idx[i]] < -GUARD_BAND || verts.sx[idx[i]] > SCR_WIDTH + GUARD_BAND ||
+			verts.sy[idx[i]] < -GUARD_BAND || verts.sy[idx[i]] > SCR_HEIGHT + GUARD_BAND)
+			return setupFace(verts, idx, index, face);
+
+		x[i] = (long)floor(verts.sx[idx[i]] * SUBPIXEL_ONE + 0.5f);
+		y[i] = (long)floor(verts.sy[idx[i]] * SUBPIXEL_ONE + 0.5f);
+	}
+
+	// Twice the signed area, the edge functions are positive inside if > 0
+	long area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+	if(area == 0)
+		return false;
+	if(area < 0)
+	{
+		long t;
+		t = x[1]; x[1] = x[2]; x[2] = t;
+		t = y[1]; y[1] = y[2]; y[2] = t;
+	}
+
+	// Bounding box of the pixel centers inside the face, clipped to the screen
+	long minX = MIN(x[0], MIN(x[1], x[2]));
+	long maxX = MAX(x[0], MAX(x[1], x[2]));
+	long minY = MIN(y[0], MIN(y[1], y[2]));
+	long maxY = MAX(y[0], MAX(y[1], y[2]));
+
+	const long half = SUBPIXEL_ONE / 2;
+	face->minX = MAX((minX - half + SUBPIXEL_ONE - 1) >> SUBPIXEL_BITS, 0);
+	face->maxX = MIN((maxX - half) >> SUBPIXEL_BITS, SCR_WIDTH - 1);
+	face->minY = MAX((minY - half + SUBPIXEL_ONE - 1) >> SUBPIXEL_BITS, 0);
+	face->maxY = MIN((maxY - half) >> SUBPIXEL_BITS, SCR_HEIGHT - 1) + 1;
+
+	if(face->minX > face->maxX || face->minY >= face->maxY)
+		return false;
+
+	// Center of the first pixel of the bounding box
+	long px = (face->minX << SUBPIXEL_BITS) + half;
+	long py = (face->minY << SUBPIXEL_BITS) + half;
+
+	for(int i = 0; i < 3; i++)
+	{
+		int j = (i == 2) ? 0 : i + 1;
+		long a = y[i] - y[j];
+		long b = x[j] - x[i];
+
+		// Relative to the first vertex of the edge, the products stay small
+		long e = a * (px - x[i]) + b * (py - y[i]);
+
+		// Top-left fill rule
+		if(!(a > 0 || (a == 0 && b > 0)))
+			e -= 1;
+
+		face->edgeE0[i] = e;
+		face->edgeDx[i] = a << SUBPIXEL_BITS;
+		face->edgeDy[i] = b << SUBPIXEL_BITS;
+	}
+
+	if(hsrMode != HSR_PAINTER)
+		calcDepthPlane(verts, idx, face);
+	else
+		face->depthA = face->depthB = face->depthC = 0;
+
+	calcTexturePlanes(verts, idx, face);
+
+	face->core = RASTER_HALFSPACE;
+	face->texture = faceTexture;
+	face->mode = Application::Instance().RenderingMode;
+	if(!faceTexture)
+		face->mode &= ~Application::TEXTURED;
+
+	return true;
+}
+
+/* Wireframe mode : a pixel inside the face is on its border if one of its 4
+	neighbours is outside. ea, eb and ec are the edge functions at the pixel. */
+static inline bool isEdgePixel(long ea, long eb, long ec, const long *dx, const long *dy)
+{
+	return ((ea - dx[0]) | (eb - dx[1]) | (ec - dx[2])) < 0 ||
+			 ((ea + dx[0]) | (eb + dx[1]) | (ec + dx[2])) < 0 ||
+			 ((ea - dy[0]) | (eb - dy[1]) | (ec - dy[2])) < 0 ||
+			 ((ea + dy[0]) | (eb + dy[1]) | (ec + dy[2])) < 0;
+}
+
+/* Render a face set up by setupHalfSpace, clipped to the rectangle
+	[cx1,cx2]x[cy1,cy2]. The screen is walked in aligned blocks of
+	BLOCK_SIZE*BLOCK_SIZE pixels : blocks outside an edge are skipped, and
+	the rows of blocks inside all the edges are filled without testing the
+	edges. Like rasterizeSpans, the pixels don't depend on the rectangle. */
+void Renderer::rasterizeBlocks(const RasterFace* face,
+										 long cx1, long cy1, long cx2, long cy2)
+{
+	Screen screen = display->GetScreen();
+	const Texture *texture = face->texture;
+	const long *e0 = face->edgeE0, *dx = face->edgeDx, *dy = face->edgeDy;
+	bool wireframe = (face->mode & Application::WIREFRAME) != 0;
+	byte visible[BLOCK_SIZE];	// pixels of a row passing the depth test
+
+	SpanKernel textured = NULL;
+	if(face->mode & Application::TEXTURED)
+		textured = spanFiller.GetTextured(texture);
+	DepthRowFiller fillDepth = getDepthRowFiller(face);
+
+	long x1 = MAX(face->minX, cx1);
+	long x2 = MIN(face->maxX, cx2);
+	long y1 = MAX(face->minY, cy1);
+	long y2 = MIN(face->maxY - 1, cy2);
+
+	// Texel steps for one pixel (16.16 fixed point)
+	long uStep = (long)(face->uA * 65536.0f);
+	long vStep = (long)(face->vA * 65536.0f);
+
+	for(long by = y1 & ~(BLOCK_SIZE - 1); by <= y2; by += BLOCK_SIZE)
+	{
+		long ya = MAX(by, y1);
+		long yb = MIN(by + BLOCK_SIZE - 1, y2);
+
+		for(long bx = x1 & ~(BLOCK_SIZE - 1); bx <= x2; bx += BLOCK_SIZE)
+		{
+			long xa = MAX(bx, x1);
+			long xb = MIN(bx + BLOCK_SIZE - 1, x2);
+
+			/* The edge functions are linear, their extrema over the block are
+				at its corners */
+			bool outside = false, inside = true;
+			long e[3];
+			for(int k = 0; k < 3 && !outside; k++)
+			{
+				e[k] = e0[k] + (xa - face->minX) * dx[k] + (ya - face->minY) * dy[k];
+				long w = (xb - xa) * dx[k], h = (yb - ya) * dy[k];
+				long c0 = e[k], c1 = e[k] + w, c2 = e[k] + h, c3 = e[k] + w + h;
+
+				if((c0 & c1 & c2 & c3) < 0)
+					outside = true;
+				else
+				if((c0 | c1 | c2 | c3) < 0)
+					inside = false;
+			}
+			if(outside)
+				continue;
+
+			for(long i = ya; i <= yb; i++, e[0]+=dy[0], e[1]+=dy[1], e[2]+=dy[2])
+			{
+				long ea = e[0], eb = e[1], ec = e[2];
+				long first = xa, last = xb;
+
+				// The pixels of a row inside the face are contiguous
+				if(!inside)
+				{
+					while(first <= xb && (ea | eb | ec) < 0)
+					{
+						first++;
+						ea += dx[0];
+						eb += dx[1];
+						ec += dx[2];
+					}
+					last = first;
+					while(last < xb && ((ea + (last - first + 1)*dx[0]) |
+											  (eb + (last - first + 1)*dx[1]) |
+											  (ec + (last - first + 1)*dx[2])) >= 0)
+						last++;
+				}
+				if(first > xb)
+					continue;
+
+				long offset = first + i*SCR_WIDTH;
+
+				// Texel of the first pixel of the block, stepped in fixed point
+				long du = uStep, dv = vStep;
+				long ui = (long)((face->uA*(bx + 0.5f) + face->uB*(i + 0.5f) + face->uC) * 65536.0f)
+							 + du * (first - bx);
+				long vi = (long)((face->vA*(bx + 0.5f) + face->vB*(i + 0.5f) + face->vC) * 65536.0f)
+							 + dv * (first - bx);
+
+				if(hsrMode == HSR_ZBUFFER)
+				{
+					(this->*fillDepth)(face, i, first, last, ui, vi, du, dv, wireframe ? visible : NULL);
+					if(wireframe)
+					{
+						for(long j = first; j <= last; j++, offset++, ea+=dx[0], eb+=dx[1], ec+=dx[2])
+						{
+							if(visible[j - first] && isEdgePixel(ea, eb, ec, dx, dy))
+								screen[offset] = 0;
+						}
+					}
+					continue;
+				}
+
+				if(textured)
+					fillRow(face, textured, i, first, last, ui, vi, du, dv);
+				if(wireframe)
+				{
+					for(long j = first; j <= last; j++, offset++, ea+=dx[0], eb+=dx[1], ec+=dx[2])
+					{
+						if(isEdgePixel(ea, eb, ec, dx, dy))
+							screen[offset] = 0;
+					}
+				}
+			}
+		}
+	}
+}
+
+/* Render the spans of a face set up by setupFace, clipped to the rectangle
+	[cx1,cx2]x[cy1,cy2]. rows[0] is the span of the scanline face->minY.
+	The pixels don't depend on the clipping rectangle, so a face rendered
+	tile by tile is identical to the same face rendered at once. */
+void Renderer::rasterizeSpans(const RasterFace* face, const HSpan* rows,
+										long cx1, long cy1, long cx2, long cy2)
+{
+	Screen screen = display->GetScreen();
+	const Texture *texture = face->texture;
+	bool wireframe = (face->mode & Application::WIREFRAME) != 0;
+	byte visible[SCR_WIDTH];	// pixels of a row passing the depth test
+
+	// The kernels are chosen once for the whole face
+	SpanKernel textured = NULL;
+	if(face->mode & Application::TEXTURED)
+		textured = spanFiller.GetTextured(texture);
+	SpanKernel flat = spanFiller.Get(SpanFiller::FLAT);
+	DepthRowFiller fillDepth = getDepthRowFiller(face);
+
+	long yStart = face->minY > cy1 ? face->minY : cy1;
+	long yEnd = face->maxY - 1 < cy2 ? face->maxY - 1 : cy2;
+
+	for(long i = yStart; i <= yEnd; i++)
+	{
+		const HSpan *span = &rows[i - face->minY];
+		long x1 = span->xStart;
+		long x2 = span->xEnd;
+
+		if(x1 > x2)
+			continue;
+
+		// Compute u,v interpolants
+		long du = 0, dv = 0;
+		long dx = x2 - x1;
+		if(dx != 0)
+		{
+			du = (span->uEnd - span->uStart) / dx;
+			dv = (span->vEnd - span->vStart) / dx;
+		}
+
+		if(hsrMode == HSR_SBUFFER)
+		{
+			// Only the visible parts of the span are kept, see EndFrame
+			sBuffer.Insert(i, x1, x2, face->depthB*i + face->depthC, face->depthA,
+								(span->uStart - du*x1) / 65536.0f, du / 65536.0f,
+								(span->vStart - dv*x1) / 65536.0f, dv / 65536.0f,
+								face->texture);
+			continue;
+		}
+
+		// Clip to the rectangle
+		long xa = x1 > cx1 ? x1 : cx1;
+		long xb = x2 < cx2 ? x2 : cx2;
+		if(xa > xb)
+			continue;
+
+		long ui = span->uStart + du * (xa - x1);
+		long vi = span->vStart + dv * (xa - x1);
+
+		long offset = xa + i*SCR_WIDTH;
+		bool edgeRow = (i == face->minY || i == face->maxY - 1);
+
+		if(hsrMode == HSR_ZBUFFER)
+		{
+			(this->*fillDepth)(face, i, xa, xb, ui, vi, du, dv, wireframe ? visible : NULL);
+			if(wireframe)
+			{
+				for(long j = xa; j <= xb; j++, offset++)
+				{
+					if(visible[j - xa] && (j==x1 || j==x2 || edgeRow))
+						screen[offset] = 0;
+				}
+			}
+			continue;
+		}
+
+		if(textured)
+			fillRow(face, textured, i, xa, xb, ui, vi, du, dv);
+		if(wireframe)
+		{
+			// Outline : the first and last rows, the ends of the other rows
+			if(edgeRow)
+			{
+				SpanJob job;
+				job.dst = &screen[offset];
+				job.count = xb - xa + 1;
+				job.color = 0;
+				flat(&job);
+			}
+			else
+			{
+				if(xa == x1)
+					screen[offset] = 0;
+				if(xb == x2)
+					screen[offset + xb - xa] = 0;
+			}
+		}
+	}
+}
+
+/* Perspective correct texel coordinates of the pixel (x,y), and the steps
+	reaching the exact coordinates of the first pixel of the next affine span.
+	The affine spans are aligned on multiples of face->perspective, which
+	divides TILE_SIZE, so they don't depend on the clipping rectangle. */
+void Renderer::perspectiveTexel(const RasterFace* face, long x, long y,
+										  long *u, long *v, long *du, long *dv) const
+{
+	long next = (x & ~(long)(face->perspective - 1)) + face->perspective;
+	float fy = y + 0.5f;
+	float x0 = x + 0.5f;
+	float x1 = next + 0.5f;
+
+	float w0 = face->wA*x0 + face->wB*fy + face->wC;
+	float w1 = face->wA*x1 + face->wB*fy + face->wC;
+	if(w0 < FLT_ERROR)
+		w0 = FLT_ERROR;
+	if(w1 < FLT_ERROR)
+		w1 = w0;	// next span beyond the horizon, keep the texel constant
+	w0 = 1.0f / w0;
+	w1 = 1.0f / w1;
+
+	float u0 = (face->uA*x0 + face->uB*fy + face->uC) * w0;
+	float v0 = (face->vA*x0 + face->vB*fy + face->vC) * w0;
+	float u1 = (face->uA*x1 + face->uB*fy + face->uC) * w1;
+	float v1 = (face->vA*x1 + face->vB*fy + face->vC) * w1;
+
+	float scale = 65536.0f / (next - x);
+	*u = (long)(u0 * 65536.0f);
+	*v = (long)(v0 * 65536.0f);
+	*du = (long)((u1 - u0) * scale);
+	*dv = (long)((v1 - v0) * scale);
+}
+
+/* Texture the pixels [x1,x2] of the scanline y with kernel. u, v, du and dv
+	are the affine texel coordinates of x1 and their steps, the perspective
+	correct ones are computed at the start of each affine span. */
+void Renderer::fillRow(const RasterFace* face, SpanKernel kernel, long y, long x1, long x2,
+							  long u, long v, long du, long dv)
+{
+	Screen row = &display->GetScreen()[y*SCR_WIDTH];
+	SpanJob job;
+	job.texture = face->texture;
+	job.color = 0;
+
+	if(!face->perspective)
+	{
+		job.dst = &row[x1];
+		job.count = x2 - x1 + 1;
+		job.u = u;
+		job.v = v;
+		job.du = du;
+		job.dv = dv;
+		kernel(&job);
+		return;
+	}
+
+	for(long x = x1; x <= x2; )
+	{
+		long next = (x & ~(long)(face->perspective - 1)) + face->perspective;
+		if(next > x2 + 1)
+			next = x2 + 1;
+
+		perspectiveTexel(face, x, y, &job.u, &job.v, &job.du, &job.dv);
+		job.dst = &row[x];
+		job.count = next - x;
+		kernel(&job);
+		x = next;
+	}
+}
+
+/* Depth test the pixels [x1,x2] of the scanline y and texture the visible
+	ones. Like the span kernels, the loop is instantiated for each address
+	mode and layout and chosen once per face (getDepthRowFiller). u, v, du
+	and dv are as in fillRow. If visible is not NULL, visible[x - x1] is set
+	to the result of the test of x. */
+template <bool textured, int address, int layout>
+void Renderer::fillRowDepth(const RasterFace* face, long y, long x1, long x2,
+									 long u, long v, long du, long dv, byte *visible)
+{
+	Screen row = &display->GetScreen()[y*SCR_WIDTH];
+	const Texture *texture = face->texture;
+	float zRow = face->depthB*y + face->depthC;
+	long offset = x1 + y*SCR_WIDTH;
+
+	for(long x = x1; x <= x2; x++, offset++, u+=du, v+=dv)
+	{
+		if(face->perspective && (x == x1 || (x & (face->perspective - 1)) == 0))
+			perspectiveTexel(face, x, y, &u, &v, &du, &dv);
+
+		bool pass = depthTest(offset, zRow + face->depthA*x);
+		if(visible)
+			visible[x - x1] = pass;
+		if(textured && pass)
+			row[x] = FetchTexelAs<address, layout>(texture, u, v);
+	}
+}
+
+Renderer::DepthRowFiller Renderer::getDepthRowFiller(const RasterFace* face) const
+{
+	if(!(face->mode & Application::TEXTURED))
+		return &Renderer::fillRowDepth<false, TEXTURE_WRAP, TEXTURE_LINEAR>;
+
+	bool tiled = face->texture->layout == TEXTURE_TILED;
+	if(face->texture->address == TEXTURE_CLAMP)
+		return tiled ? &Renderer::fillRowDepth<true, TEXTURE_CLAMP, TEXTURE_TILED> :
+							&Renderer::fillRowDepth<true, TEXTURE_CLAMP, TEXTURE_LINEAR>;
+	return tiled ? &Renderer::fillRowDepth<true, TEXTURE_WRAP, TEXTURE_TILED> :
+						&Renderer::fillRowDepth<true, TEXTURE_WRAP, TEXTURE_LINEAR>;
 }
 
 /* Scans the edge between the 2 specified vertices (v1 and v2) and fills
 the array of spans (horizontal lines) used to display the pixels */
-void Renderer::scanEdge(const Vertex *v1, const Vertex *v2)
+void Renderer::scanEdge(const VertexArrays &verts, int i1, int i2)
 {
-	Vertex *vF, *vL;
-	Vertex_TexCoord *tF,*tL;
+#ifdef FIXED_PIPELINE
+	if(fixedPipeline)
+	{
+		scanEdgeFixed(verts, i1, i2);
+		return;
+	}
+#endif
+
+	int	iF, iL;
 	long	fy, ly;
 
 	// Skip horizontal edge (for now ;))
-	if(v1->scr[1] >= v2->scr[1] - FLT_ERROR &&
-	   v1->scr[1] <= v2->scr[1] + FLT_ERROR) return;
+	if(verts.sy[i1] >= verts.sy[i2] - FLT_ERROR &&
+	   verts.sy[i1] <= verts.sy[i2] + FLT_ERROR) return;
 
 	// Order the vertices in increasing y order
-	if(v1->scr[1] < v2->scr[1]) {
-		vF = (Vertex*)v1;
-		vL = (Vertex*)v2;
+	if(verts.sy[i1] < verts.sy[i2]) {
+		iF = i1;
+		iL = i2;
 	}
 	else {
-		vF = (Vertex*)v2;
-		vL = (Vertex*)v1;
+		iF = i2;
+		iL = i1;
 	}
 
 	// Round the y positions	
-	fy = (long)vF->scr[1];
-	ly = (long)vL->scr[1];
+	fy = (long)verts.sy[iF];
+	ly = (long)verts.sy[iL];
 
 	// Clip (or reject) the edge
 	if(fy >= SCR_HEIGHT)
@@ -612,8 +1998,8 @@ void Renderer::scanEdge(const Vertex *v1, const Vertex *v2)
 	float slopeX,x;
 	long sx;
 
-	x	= vF->scr[0];
-	slopeX	= (vL->scr[0] - vF->scr[0]) / (vL->scr[1] - vF->scr[1]);
+	x	= verts.sx[iF];
+	slopeX	= (verts.sx[iL] - verts.sx[iF]) / (verts.sy[iL] - verts.sy[iF]);
 
 	// Increase x if needed (special case of clip)
 	if(fy < 0)
@@ -645,6 +2031,197 @@ void Renderer::scanEdge(const Vertex *v1, const Vertex *v2)
 	}
 }
 
+#ifdef FIXED_PIPELINE
+// Same as scanEdge on the 16.16 screen coordinates
+void Renderer::scanEdgeFixed(const VertexArrays &verts, int i1, int i2)
+{
+	int iF, iL;
+
+	// Skip horizontal edge
+	if(abs(verts.fsy[i1] - verts.fsy[i2]) <= FIXED_ERROR) return;
+
+	// Order the vertices in increasing y order
+	if(verts.fsy[i1] < verts.fsy[i2]) {
+		iF = i1;
+		iL = i2;
+	}
+	else {
+		iF = i2;
+		iL = i1;
+	}
+
+	long fy = verts.fsy[iF] >> 16;
+	long ly = verts.fsy[iL] >> 16;
+
+	// Clip (or reject) the edge
+	if(fy >= SCR_HEIGHT)
+		return;
+	if(ly < 0)
+		return;
+	if(ly >= SCR_HEIGHT)
+		ly = SCR_HEIGHT-1;
+
+	// 16.16, on 64 bits as the saturated projections may be far off screen
+	FixedWide x = verts.fsx[iF];
+	FixedWide slopeX = ((FixedWide)(verts.fsx[iL] - verts.fsx[iF]) << 16) /
+							 (verts.fsy[iL] - verts.fsy[iF]);
+
+	if(fy < 0)
+	{
+		x += slopeX * (0 - fy);
+		fy = 0;
+	}
+
+	if(fy < minY)
+		minY = fy;
+	if(ly > maxY)
+		maxY = ly;
+
+	for(int i = fy; i < ly; i++)
+	{
+		long sx = (long)(x >> 16);
+
+		if(sx < spans[i].xStart)
+			spans[i].xStart = sx;
+		if(sx > spans[i].xEnd)
+			spans[i].xEnd = sx;
+		x += slopeX;
+	}
+}
+#endif
+
+/* Grid of n*n quads from origin, along du and dv, the texture being mapped
+	once on it. Its faces are clockwise seen from the side du x dv points
+	away from. */
+static void buildGrid(Object *obj, int n, const Vector3 &origin, const Vector3 &du, const Vector3 &dv)
+{
+	int row = n + 1;
+	Vector3 normal = Cross(du, dv);
+	normal.Normalize();
+
+	obj->free();
+	obj->numVerts = row * row;
+	obj->arrays.Alloc(obj->numVerts);
+	for(int i = 0; i < row; i++)
+	{
+		for(int j = 0; j < row; j++)
+		{
+			float s = (float)j / n, t = (float)i / n;
+			Vector3 p = origin + du * s + dv * t;
+			int k = i * row + j;
+			obj->arrays.x[k] = p.x;
+			obj->arrays.y[k] = p.y;
+			obj->arrays.z[k] = p.z;
+			obj->arrays.nx[k] = normal.x;
+			obj->arrays.ny[k] = normal.y;
+			obj->arrays.nz[k] = normal.z;
+			obj->arrays.u[k] = s;
+			obj->arrays.v[k] = t;
+		}
+	}
+	obj->arrays.Finish();
+	calcBounds(obj->arrays, &obj->bounds);
+
+	obj->numFaces = 2 * n * n;
+	obj->faces = new Triangle[obj->numFaces];
+	for(int i = 0, f = 0; i < n; i++)
+	{
+		for(int j = 0; j < n; j++)
+		{
+			int a = i * row + j;
+			obj->faces[f].a = a;
+			obj->faces[f].b = a + row;
+			obj->faces[f++].c = a + 1;
+			obj->faces[f].a = a + 1;
+			obj->faces[f].b = a + row;
+			obj->faces[f++].c = a + row + 1;
+		}
+	}
+}
+
+/* Render obj alone in front of the camera during a quarter of second.
+	Returns the time of a frame in ms, the clear included. */
+double Renderer::timeObject(Object *obj)
+{
+	int frames = 0;
+	clock_t start = clock(), end;
+	do
+	{
+		display->Clear();
+		BeginFrame();
+		Identity();
+		RenderObject(obj);
+		EndFrame();
+		frames++;
+		end = clock();
+	} while(end - start < CLOCKS_PER_SEC / 4);
+
+	return 1000.0 * (end - start) / CLOCKS_PER_SEC / frames;
+}
+
+/* The plane y = -1 recedes from z = 1 to z = 30 : its texels per pixel vary
+	a lot along the scanlines, it is the worst case of affine texturing */
+void Renderer::BenchmarkPerspective(int textureID)
+{
+	static const int spans[] = {0, 16, 8};
+	static const int numSpans = sizeof(spans) / sizeof(spans[0]);
+
+	if(!TextureManager::Instance().GetTexture(textureID))
+	{
+		printf("Perspective : no texture to benchmark\n");
+		return;
+	}
+
+	Object plane;
+	buildGrid(&plane, 8, Vector3(-4, -1, 1), Vector3(8, 0, 0), Vector3(0, 0, 29));
+	plane.textureID = textureID;
+
+	Mat4x3 mat = matWorld;
+	int span = perspectiveSpan;
+
+	double affine = 0;
+	for(int i = 0; i < numSpans; i++)
+	{
+		SetPerspective(spans[i]);
+		double ms = timeObject(&plane);
+		if(spans[i] == 0)
+		{
+			affine = ms;
+			printf("Perspective affine : %6.2f ms/frame\n", ms);
+		}
+		else
+			printf("Perspective n=%-4d : %6.2f ms/frame (x%.2f)\n", spans[i], ms, ms / affine);
+	}
+
+	SetPerspective(span);
+	matWorld = mat;
+}
+
+/* A grid of 100x100 quads facing the camera, its triangles are 2 or 3
+	pixels tall. It has no texture, so the textured mode doesn't fill it : a
+	frame is the clear, the transform and the setup of the faces. The
+	scanline core is used, it is the one which resets the scanlines. */
+void Renderer::BenchmarkSetup(void)
+{
+	Object grid;
+	buildGrid(&grid, 100, Vector3(-2, -1.5f, 2), Vector3(4, 0, 0), Vector3(0, 3, 0));
+
+	Mat4x3 mat = matWorld;
+	int core = rasterCore;
+	rasterCore = RASTER_SCANLINE;
+
+	resetAllSpans = true;
+	double before = timeObject(&grid);
+	resetAllSpans = false;
+	double after = timeObject(&grid);
+
+	printf("Face setup %d faces : all scanlines reset %6.2f ms/frame, covered ones %6.2f ms/frame (x%.1f)\n",
+			 grid.numFaces, before, after, before / after);
+
+	rasterCore = core;
+	matWorld = mat;
+}
+
 #ifdef DEBUG_MODE
 int Renderer::L3DCBmp()
 {
@@ -12,60 +12,159 @@
 
 //-------------------------------------------------------------------- INCLUDES
 #include "Display.h"
+#include "Object.h"
 #include "Maths/math3D.h"
 #include "TextureManager.h"
+#include "DepthSort.h"
+#include "FrameArena.h"
+#include "SpanBuffer.h"
+#include "SpanFiller.h"
+#include <vector>
 
 //---------------------------------------------------------------------- CONSTS
 
 #define MIN_FOV		60
 #define MAX_FOV		100
 
+// View frustum, the other planes go through the viewport borders
+#define NEAR_PLANE		0.1f
+#define FAR_PLANE			1000.0f
+
+// Planes of the view frustum (Vertex::clip)
+#define CLIP_NEAR			0x01
+#define CLIP_FAR			0x02
+#define CLIP_LEFT			0x04
+#define CLIP_RIGHT		0x08
+#define CLIP_TOP			0x10
+#define CLIP_BOTTOM		0x20
+
+#ifdef FIXED_PIPELINE
+	// NEAR_PLANE, FAR_PLANE and FLT_ERROR in 16.16 fixed point
+	#define NEAR_PLANE_FIXED	6554
+	#define FAR_PLANE_FIXED		(1000 << 16)
+	#define FIXED_ERROR			7
+
+	// The projections are saturated to +-8192 pixels
+	#define SCREEN_FIXED_MAX	(8192 << 16)
+
+#endif
+
+// Depth buckets of the render queue, between the near and far planes
+#define QUEUE_DEPTH_BUCKETS	64
+
+/* Depth buffer values are proportional to 1/z and saturate for z smaller than
+	ZBUFFER_NEAR */
+#define ZBUFFER_NEAR		NEAR_PLANE
+#define ZBUFFER_MAX16	0xFFFF
+#define ZBUFFER_MAX32	0xFFFFFF	// low 24 bits, the high 8 bits store the epoch
+
+/* Half-space rasterizer : vertices are snapped to 1/16 of pixel, and faces
+	having a vertex farther than GUARD_BAND pixels from the screen are
+	rendered by the scanline core (the edge functions would overflow) */
+#define SUBPIXEL_BITS	4
+#define SUBPIXEL_ONE		(1 << SUBPIXEL_BITS)
+#define BLOCK_SIZE		8
+#define GUARD_BAND		512
+
+/* Perspective correct texturing : u and v are exact every N pixels and
+	interpolated linearly in between. N is a power of 2 dividing TILE_SIZE. */
+#define MAX_PERSPECTIVE_SPAN		32
+
 //----------------------------------------------------------------------- TYPES
 typedef struct
 {
 	// Start and end position of the span
 	long xStart;
 	long xEnd;
+	// Texture coordinates at the start and end positions (16.16 fixed point)
 	long uStart;
 	long uEnd;
 	long vStart;
 	long vEnd;
 } HSpan;
 
+// Statistics of a frame
+typedef struct
+{
+	int		numObjects,			// objects submitted
+				numCulled,			// objects outside the view frustum
+				numFacesTested,	// faces of the objects not culled
+				numFacesCulled,	// faces outside the frustum or culled
+				numFaces;			// faces sent to the rasterizers
+	long	numTexels;			// texels covered by the faces, at their mip level
+	int		numTextureSwitches;	// textures bound
+	long	scratchHighWater;	// bytes of the frame arena needed by the scene
+} FrameStats;
+
+/* Object submitted for the frame. The objects are rendered in the order of
+	their keys, compared field by field. */
+typedef struct
+{
+	Object	*obj;
+	Mat4x3	matWorld;			// world matrix at the submission
+	int		cull;					// CULL_RESULT
+	int		key[3];
+} QueueItem;
+
+/* Visible face of the frame, when the faces of all the objects are sorted
+	together (HSR_PAINTER and HSR_SBUFFER) */
+typedef struct
+{
+	int		verts[3];			// indices in the frame vertices
+	float		cenZ;					// z centroid (used for sorting)
+	int		textureID;
+	int		index;				// face of the object (logs)
+} FrameFace;
+
+// Face ready to be rendered, its spans are stored separately
+typedef struct
+{
+	int		core;				// RASTER_CORE used to set up the face
+	long		minY,				// first scanline
+				maxY;				// last scanline + 1
+	long		minX,				// bounding box (RASTER_HALFSPACE only)
+				maxX;
+	long		edgeE0[3],			// edge functions at the center of (minX,minY)
+				edgeDx[3],			// edge function steps for one pixel in x
+				edgeDy[3];			// and in y
+	float		uA, uB, uC,			// texel planes (u/z and v/z if perspective)
+				vA, vB, vC;
+	float		wA, wB, wC;			// 1/z plane (perspective only)
+	int		perspective;		// affine span length, 0 = affine texturing
+	float		depthA,				// depth plane :
+				depthB,				// depth = depthA*x + depthB*y + depthC
+				depthC;
+	const Texture	*texture;
+	byte		mode;				// Application::MODE flags
+} RasterFace;
+
 //--------------------------------------------------------------------- CLASSES
 
+class TileBinner;
+
 class Renderer
 {
 private:
 	Display* display;
 
-	Mat4x4		matWorld;			// World matrix
+	Mat4x3		matWorld;			// World matrix (affine)
 
 	long		minY,				// Y position of the first span
 				maxY;				// Y position of the last span
-	float		diffY;			// maxY-minY
-
-	long x1, x2; // x positions of a span
-
-	float dx;
+	float		diffY;			// 1/rows of the edges of a flat triangle
 
 	float u0,v0,u1,v1,u2,v2; // texture coordinates
 
 	// variables used for texture mapping
 	float ul,vl; // left
 	float ur,vr; // right
-	float ui,vi; // current
-	float du,dv; // u,v interpolants
 	float dudyl,dvdyl;
 	float dudyr,dvdyr;
 
 	int iLeft, iRight; // indices of the left and right vertices in a triangle
 
-	byte* pixel; // pointer on the current pixel
-
 	int yMiddle; // y coordinate of the middle vertex on the y axis
 
-	float fTemp; // variable used for the SWAP macro
 
 	HSpan		spans[SCR_HEIGHT];	// Horizontal spans
 
@@ -77,51 +176,365 @@ private:
 	long		vp[4];				// viewport
 	float		halfVpW,			// half viewport width
 				halfVpH;			// half viewport height
+#ifdef FIXED_PIPELINE
+	int		centerFixed[2],	// center of the viewport (16.16)
+				clipFixed[2];		// halfVpW+1 and halfVpH+1 (16.16)
+#endif
+	bool		fixedPipeline;		// vertices and edges in 16.16 (FIXED_PIPELINE)
 
 	void		*frameBuffer;		// frame buffer bits
 	long		frameBufferPitch;	// frame buffer pitch
 
 	Texture* currentTexture;		// currentTexture (set with SetTexture)
+	const Texture* faceTexture;	// mip level of currentTexture for the face set up
+	bool		mipmapping;
+
+	int		hsrMode;				// hidden surface removal mode (HSR_MODE)
+	int		depthFormat;			// depth buffer format (DEPTH_FORMAT)
+	void		*zBuffer;			// depth buffer (SCR_WIDTH*SCR_HEIGHT values)
+	SpanBuffer	sBuffer;			// visible spans (HSR_SBUFFER)
+	uint		depthEpoch;			// high bits of the 32 bits depth values
+	float		depthScale;			// 1/z to depth buffer value
+
+	TileBinner	*binner;			// tiled and multithreaded rasterization
+	SpanFiller	spanFiller;			// pixel loops
+	int		rasterCore;			// RASTER_CORE
+	int		faceCulling;		// FACE_CULLING
+	int		perspectiveSpan;	// 0 = affine texturing
+	bool		resetAllSpans;		// setupFace resets every scanline (BenchmarkSetup)
 
 	void calcFocal(void);
 
-	// Project the specified vertex v
-	inline void project(Vertex *v)
+	/* Project the i-th vertex of v. It must be in front of the near plane,
+		see clipCode */
+	inline void project(VertexArrays &v, int i)
 	{
-		// We shouldn't perform division by zero, no ?
-		if(v->coordsWorld.z >= -FLT_ERROR && v->coordsWorld.z <= FLT_ERROR)
-			v->coordsWorld.z = 1.0f;
-
 		// Project the point	
-		float inv = ((float)FOCAL / v->coordsWorld.z);
-		v->scr[0] = v->coordsWorld.x * inv + halfVpW + vp[0];
-		v->scr[1] = -v->coordsWorld.y * inv + halfVpH + vp[1];
+		float inv = ((float)FOCAL / v.wz[i]);
+		v.sx[i] = v.wx[i] * inv + halfVpW + vp[0];
+		v.sy[i] = -v.wy[i] * inv + halfVpH + vp[1];
 	}
 
-	void scanEdge(const Vertex *v1, const Vertex *v2);	
+	/* Planes of the view frustum the point p (camera space) is outside of.
+		Each plane is a half space, so a face is outside the frustum if its 3
+		vertices are outside of the same plane, even behind the camera. */
+	inline int clipCode(float px, float py, float pz) const
+	{
+		int code = 0;
+		if(pz < NEAR_PLANE)
+			code |= CLIP_NEAR;
+		if(pz > FAR_PLANE)
+			code |= CLIP_FAR;
+
+		// Projection inside the viewport : |x*FOCAL/z| <= halfVpW
+		float x = px * FOCAL, y = -py * FOCAL;
+		float w = (halfVpW + 1) * pz, h = (halfVpH + 1) * pz;
+		if(x < -w)
+			code |= CLIP_LEFT;
+		if(x > w)
+			code |= CLIP_RIGHT;
+		if(y < -h)
+			code |= CLIP_TOP;
+		if(y > h)
+			code |= CLIP_BOTTOM;
+		return code;
+	}
 
-	void rasterizeFace(Object* obj,int index,float col);
+	inline int clipCode(const Vector3 &p) const
+	{
+		return clipCode(p.x, p.y, p.z);
+	}
+
+#ifdef FIXED_PIPELINE
+	// Same as clipCode, on 16.16 coordinates
+	inline int clipCodeFixed(int px, int py, int pz) const
+	{
+		int code = 0;
+		if(pz < NEAR_PLANE_FIXED)
+			code |= CLIP_NEAR;
+		if(pz > FAR_PLANE_FIXED)
+			code |= CLIP_FAR;
+
+		FixedWide x = (FixedWide)px * FOCAL, y = -(FixedWide)py * FOCAL;
+		FixedWide w = ((FixedWide)clipFixed[0] * pz) >> 16;
+		FixedWide h = ((FixedWide)clipFixed[1] * pz) >> 16;
+		if(x < -w)
+			code |= CLIP_LEFT;
+		if(x > w)
+			code |= CLIP_RIGHT;
+		if(y < -h)
+			code |= CLIP_TOP;
+		if(y > h)
+			code |= CLIP_BOTTOM;
+		return code;
+	}
+
+	/* p*FOCAL/z in 16.16 (p and z in 16.16), z in front of the near plane.
+		inv is FOCAL/z in 8.24, computed once for both coordinates */
+	static inline int projectFixed(int p, FixedWide inv)
+	{
+		FixedWide s = ((FixedWide)p * inv) >> 24;
+		return (int)CLAMP(s, (FixedWide)-SCREEN_FIXED_MAX, (FixedWide)SCREEN_FIXED_MAX);
+	}
+
+	/* Same as project from the 16.16 world coordinates of the i-th vertex.
+		The float screen coordinates are only written for the float stages */
+	inline void projectFixedVertex(VertexArrays &v, int i)
+	{
+		FixedWide inv = ((FixedWide)FOCAL << 40) / v.fwz[i];
+		v.fsx[i] = projectFixed(v.fwx[i], inv) + centerFixed[0];
+		v.fsy[i] = projectFixed(-v.fwy[i], inv) + centerFixed[1];
+		v.sx[i] = Fixed16::FromRaw(v.fsx[i]).ToFloat();
+		v.sy[i] = Fixed16::FromRaw(v.fsy[i]).ToFloat();
+	}
+#endif
+
+	// Clip the span to the screen, returns false if it is empty
+	static inline bool clipSpan(HSpan *span)
+	{
+		if(span->xStart >= SCR_WIDTH || span->xEnd < 0)
+		{
+			span->xStart = 0;
+			span->xEnd = -1;
+			return false;
+		}
+		if(span->xStart < 0)
+			span->xStart = 0;
+		if(span->xEnd >= SCR_WIDTH)
+			span->xEnd = SCR_WIDTH - 1;
+		return true;
+	}
+
+	// Scanline of the i-th vertex of v, as scanEdge rounds it
+	inline long screenRow(const VertexArrays &v, int i) const
+	{
+#ifdef FIXED_PIPELINE
+		if(fixedPipeline)
+			return v.fsy[i] >> 16;
+#endif
+		return (long)v.sy[i];
+	}
+
+	// Lowest scanline of the triangle idx of v, before clipping to the screen
+	inline long lowestRow(const VertexArrays &v, const int *idx) const
+	{
+		long row = screenRow(v, idx[0]);
+		for(int i = 1; i < 3; i++)
+			row = MAX(row, screenRow(v, idx[i]));
+		return row;
+	}
+
+	VertexArrays	clipVerts;		// face crossing the near plane, and the vertices clipNear creates
+	VertexArrays	frameVerts;		// vertices of the faces sorted by flushSortedFaces
+
+	FrameStats	stats,				// current frame
+					lastStats;			// last complete frame
+
+	std::vector<QueueItem>	queue;	// objects submitted for the frame
+	std::vector<int>			frameOrder;	// faces of the frame from back to front
+
+	FrameArena	frameArena;			// temporary buffers, released by BeginFrame
+
+	DepthSorter	depthSorter;		// orders the visible faces
+
+	// Returns false if the index-th face of the object can be skipped
+	inline bool isFaceVisible(const Object *obj, int index) const
+	{
+		const VertexArrays &v = obj->arrays;
+		int a = obj->faces[index].a;
+		int b = obj->faces[index].b;
+		int c = obj->faces[index].c;
+
+		// Trivial reject : outside the view frustum
+		if(v.clip[a] & v.clip[b] & v.clip[c])
+			return false;
+
+		if(faceCulling == CULL_NONE)
+			return true;
+
+		/* Signed area of the projected face, positive if its vertices are
+			clockwise on the screen. Vertices behind the near plane are not
+			projected : the volume of the tetrahedron formed with the eye has
+			the opposite sign, the screen y axis being -Y * FOCAL / Z. */
+		float area;
+		if((v.clip[a] | v.clip[b] | v.clip[c]) & CLIP_NEAR)
+		{
+			Vector3 pa(v.wx[a], v.wy[a], v.wz[a]);
+			area = -Dot(pa, Cross(Vector3(v.wx[b], v.wy[b], v.wz[b]) - pa,
+										Vector3(v.wx[c], v.wy[c], v.wz[c]) - pa));
+		}
+		else
+		{
+			area = (v.sx[b] - v.sx[a]) * (v.sy[c] - v.sy[a]) -
+					 (v.sy[b] - v.sy[a]) * (v.sx[c] - v.sx[a]);
+		}
+
+		return faceCulling == CULL_BACK ? area > 0 : area < 0;
+	}
+
+	/* Depth test of the pixel at the specified offset in the depth buffer.
+		Returns true and stores the depth if the pixel is visible */
+	inline bool depthTest(long offset, float z) const
+	{
+		if(z <= 0)
+			return false;
+
+		if(depthFormat == DEPTH_16)
+		{
+			word *depth = (word*)zBuffer + offset;
+			// Beyond ZBUFFER_MAX16 * ZBUFFER_NEAR, z is below 1 : clamped to
+			// the farthest value, 0 being the cleared buffer
+			word value = (word)(z > ZBUFFER_MAX16 ? ZBUFFER_MAX16 : z < 1 ? 1 : z);
+			if(value <= *depth)
+				return false;
+			*depth = value;
+		}
+		else
+		{
+			uint *depth = (uint*)zBuffer + offset;
+			uint value = depthEpoch | (uint)(z > ZBUFFER_MAX32 ? ZBUFFER_MAX32 : z);
+			if(value <= *depth)
+				return false;
+			*depth = value;
+		}
+		return true;
+	}
+
+	/* The triangles are 3 indices idx in arrays of vertices verts : the
+		vertices of an object, of the frame (flushSortedFaces) or of the near
+		plane clipping (clipVerts) */
+	void calcPlane(const VertexArrays &verts, const int *idx, float w0, float w1, float w2,
+						float *a, float *b, float *c);
+	void calcDepthPlane(const VertexArrays &verts, const int *idx, RasterFace *face);
+	void calcTexturePlanes(const VertexArrays &verts, const int *idx, RasterFace *face);
+	const Texture* selectMipmap(const VertexArrays &verts, const int *idx);
+	void clearDepth(void);
+
+	enum CULL_RESULT {
+		CULL_OUTSIDE,
+		CULL_INTERSECT,
+		CULL_INSIDE};
+
+	int cullObject(const Object* obj, float *depth) const;
+	void bindTexture(int textureID);
+	void flushQueue(void);
+	void flushSortedFaces(void);
+	int copyVertex(const Object *obj, int index, int *remap, int *numVerts);
+	int visibleFaces(Object *obj, int cull, int *visible);
+	void renderObject(Object *obj, int cull);
+	void transformVertices(Object* obj, bool clip);
+
+	void scanEdge(const VertexArrays &verts, int i1, int i2);
+	void interpolateTexels(const VertexArrays &verts, const int *idx, int triangleType, int UVIndex0, int indexMiddle);
+	void clipEdge(VertexArrays &v, int a, int b, int n);
+#ifdef FIXED_PIPELINE
+	void transformVerticesFixed(VertexArrays &v, const Mat4x3 &m, bool clip);
+	void clipEdgeFixed(VertexArrays &v, int a, int b, int n);
+	void scanEdgeFixed(const VertexArrays &verts, int i1, int i2);
+	void interpolateTexelsFixed(const VertexArrays &verts, const int *idx, int triangleType, int UVIndex0, int indexMiddle);
+#endif
+
+	int clipNear(const VertexArrays &verts, const int *idx, int *poly);
+
+	void rasterizeFace(const VertexArrays &verts, int a, int b, int c, int index);
+	void rasterizeTriangle(const VertexArrays &verts, const int *idx, int index);
+	bool setupFace(const VertexArrays &verts, const int *idx, int index, RasterFace* face);
+	bool setupHalfSpace(const VertexArrays &verts, const int *idx, int index, RasterFace* face);
+	double timeObject(Object *obj);
+
+	void rasterizeRect(const RasterFace* face, const HSpan* rows,
+							 long cx1, long cy1, long cx2, long cy2);
+	void rasterizeSpans(const RasterFace* face, const HSpan* rows,
+							  long cx1, long cy1, long cx2, long cy2);
+	void rasterizeBlocks(const RasterFace* face,
+								long cx1, long cy1, long cx2, long cy2);
+	void perspectiveTexel(const RasterFace* face, long x, long y,
+								 long *u, long *v, long *du, long *dv) const;
+	void fillRow(const RasterFace* face, SpanKernel kernel, long y, long x1, long x2,
+					 long u, long v, long du, long dv);
+
+	typedef void (Renderer::*DepthRowFiller)(const RasterFace* face, long y, long x1, long x2,
+														  long u, long v, long du, long dv, byte *visible);
+	template <bool textured, int address, int layout>
+	void fillRowDepth(const RasterFace* face, long y, long x1, long x2,
+							long u, long v, long du, long dv, byte *visible);
+	DepthRowFiller getDepthRowFiller(const RasterFace* face) const;
+
+	friend class TileBinner;
 
 public:
+	enum HSR_MODE {
+		HSR_PAINTER,		// faces sorted from back to front
+		HSR_ZBUFFER,		// per pixel depth test, no sorting
+		HSR_SBUFFER,		// span buffer, faces sorted from front to back
+		NUM_HSR_MODES};
+
+	enum DEPTH_FORMAT {
+		DEPTH_16,
+		DEPTH_32};
+
+	enum RASTER_CORE {
+		RASTER_SCANLINE,	// edges scanned into spans
+		RASTER_HALFSPACE,	// integer edge functions, 8x8 blocks
+		NUM_RASTER_CORES};
+
+	enum FACE_CULLING {
+		CULL_NONE,
+		CULL_BACK,			// counterclockwise faces on the screen
+		CULL_FRONT,			// clockwise faces on the screen
+		NUM_FACE_CULLINGS};
+
 	Renderer(Display* display);
 	~Renderer(void);
 
 	bool Init(void);
 	void Deinit(void);
 
+	void BeginFrame(void);
+	DepthSorter& GetDepthSorter(void);
+	int GetDepthFormat(void) const;
+	int GetFaceCulling(void) const;
+	bool GetFixedPipeline(void) const;
+	const FrameStats& GetFrameStats(void) const;
+	int GetHSRMode(void) const;
+	bool GetMipmapping(void) const;
+	int GetPerspective(void) const;
+	int GetRasterCore(void) const;
+	int GetRasterThreads(void) const;
+	SpanFiller& GetSpanFiller(void);
+	FrameArena& GetFrameArena(void);
 	float GetFOV(void) const;	
 	void GetViewport(long *x, long *y, long *w, long *h);
 	void GetViewport(long *viewport);
+	void EndFrame(void);
 	void Identity();
 	void RenderObject(Object *obj);
+	void SubmitObject(Object *obj);
 	void Rotate(const Vector3& vec);
 	void SetCurrentTexture(Texture* texture);
+	void SetDepthFormat(int format);
+	void SetFaceCulling(int mode);
+	void SetFixedPipeline(bool enable);
 	void SetFOV(float FOV);
 	void SetFrameBuffer(void *bits, long pitch, dword bpp);
+	void SetHSRMode(int mode);
+	void SetMipmapping(bool enable);
+	void SetPerspective(int span);
+	void SetRasterCore(int core);
+	void SetRasterThreads(int num);
 	void SetTransMat(const Mat4x4& mat);
 	void SetViewport(long x, long y, long w, long h);
 	void Translate(const Vector3& vec);	
 
+	/* Print the time of a frame of a receding textured plane, affine and
+		perspective correct every 16 and 8 pixels */
+	void BenchmarkPerspective(int textureID);
+
+	/* Print the time of a frame of many small faces, with setupFace
+		resetting all the scanlines for each face (as it used to) and only the
+		ones the face covers */
+	void BenchmarkSetup(void);
+
 #ifdef DEBUG
 	int L3DCBmp(); //display a L3DC texture
 #endif //DEBUG
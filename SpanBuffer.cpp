@@ -0,0 +1,210 @@
+/**
+* File : SpanBuffer.cpp
+* Description : S-buffer, hidden surface removal at the span level
+*
+* Author(s) : ALucchi
+* Date of creation : 17/10/2026
+* Modification(s) :
+*/
+
+//-------------------------------------------------------------------- INCLUDES
+#include "Object.h"
+#include "SpanBuffer.h"
+
+//--------------------------------------------------------------------- CLASSES
+
+SpanBuffer::SpanBuffer()
+{
+	maxSpans = SBUFFER_INITIAL_SPANS;
+	spans = new SSpan[maxSpans];
+	Clear();
+}
+
+SpanBuffer::~SpanBuffer()
+{
+	delete[] spans;
+}
+
+void SpanBuffer::Clear(void)
+{
+	for(int i = 0; i < SCR_HEIGHT; i++)
+		head[i] = -1;
+	numSpans = 0;
+}
+
+int SpanBuffer::GetNumSpans(void) const
+{
+	return numSpans;
+}
+
+/* Allocate a span from the pool. The pool is never shrunk, so its size
+	converges to the needs of the scene. */
+int SpanBuffer::newSpan(const SSpan &span, short x1, short x2)
+{
+	// span may be in the pool, copy it before growing the pool
+	SSpan s = span;
+
+	if(numSpans == maxSpans)
+	{
+		SSpan *newSpans = new SSpan[maxSpans * 2];
+		memcpy(newSpans, spans, maxSpans * sizeof(SSpan));
+		delete[] spans;
+		spans = newSpans;
+		maxSpans *= 2;
+	}
+
+	s.x1 = x1;
+	s.x2 = x2;
+	spans[numSpans] = s;
+	return numSpans++;
+}
+
+/* Replace the pixels [x1,x2] of the span cur by span. prev is the span before
+	cur (-1 if cur is the first one of the scanline y) and is updated to the
+	span which was inserted. */
+void SpanBuffer::replace(long y, int *prev, int cur, short x1, short x2, const SSpan &span)
+{
+	SSpan old = spans[cur];
+	int next = old.next;
+
+	// Right part of the old span
+	if(x2 < old.x2)
+	{
+		next = newSpan(old, x2 + 1, old.x2);
+		spans[next].next = old.next;
+	}
+
+	int mid = newSpan(span, x1, x2);
+	spans[mid].next = next;
+
+	if(x1 > old.x1)
+	{
+		// Keep the left part of the old span
+		spans[cur].x2 = x1 - 1;
+		spans[cur].next = mid;
+	}
+	else
+	{
+		// The old span is not visible anymore
+		if(*prev == -1)
+			head[y] = mid;
+		else
+			spans[*prev].next = mid;
+	}
+
+	*prev = mid;
+}
+
+void SpanBuffer::Insert(long y, long x1, long x2, float z0, float dz,
+								float u0, float du, float v0, float dv, const Texture *texture)
+{
+	SSpan n;
+	n.z0 = z0;
+	n.dz = dz;
+	n.u0 = u0;
+	n.du = du;
+	n.v0 = v0;
+	n.dv = dv;
+	n.texture = texture;
+
+	int prev = -1;
+	int cur = head[y];
+	long x = x1;
+
+	while(x <= x2)
+	{
+		// Skip the spans which end before x
+		while(cur != -1 && spans[cur].x2 < x)
+		{
+			prev = cur;
+			cur = spans[cur].next;
+		}
+
+		if(cur == -1 || spans[cur].x1 > x2)
+		{
+			// Nothing in front of the rest of the span
+			int s = newSpan(n, (short)x, (short)x2);
+			spans[s].next = cur;
+			if(prev == -1)
+				head[y] = s;
+			else
+				spans[prev].next = s;
+			return;
+		}
+
+		if(spans[cur].x1 > x)
+		{
+			// Uncovered pixels before the next span
+			int s = newSpan(n, (short)x, spans[cur].x1 - 1);
+			spans[s].next = cur;
+			if(prev == -1)
+				head[y] = s;
+			else
+				spans[prev].next = s;
+			prev = s;
+			x = spans[cur].x1;
+			continue;
+		}
+
+		// spans[cur] covers [x,last] : compare the depths at both ends
+		const SSpan &e = spans[cur];
+		long last = e.x2 < x2 ? e.x2 : x2;
+		float d0 = (n.z0 - e.z0) + (n.dz - e.dz) * x;
+		float d1 = (n.z0 - e.z0) + (n.dz - e.dz) * last;
+		long first;
+
+		if(d0 <= 0 && d1 <= 0)
+		{
+			// Hidden
+			x = last + 1;
+			continue;
+		}
+
+		if(d0 > 0 && d1 > 0)
+		{
+			first = x;
+		}
+		else
+		{
+			// The spans intersect at xc
+			float xc = x + d0 / (d0 - d1) * (last - x);
+			if(d0 > 0)
+			{
+				first = x;
+				last = CLAMP((long)xc, x, last);
+			}
+			else
+			{
+				first = CLAMP((long)xc + 1, x, last);
+			}
+		}
+
+		replace(y, &prev, cur, (short)first, (short)last, n);
+		cur = spans[prev].next;
+		x = last + 1;
+	}
+}
+
+void SpanBuffer::Flush(Screen screen, const SpanFiller &filler)
+{
+	SpanJob job;
+
+	for(int y = 0; y < SCR_HEIGHT; y++)
+	{
+		for(int i = head[y]; i != -1; i = spans[i].next)
+		{
+			const SSpan &s = spans[i];
+			if(!s.texture)
+				continue;
+
+			job.dst = &screen[s.x1 + y*SCR_WIDTH];
+			job.count = s.x2 - s.x1 + 1;
+			job.u = (long)((s.u0 + s.du * s.x1) * 65536.0f);
+			job.v = (long)((s.v0 + s.dv * s.x1) * 65536.0f);
+			job.du = (long)(s.du * 65536.0f);
+			job.dv = (long)(s.dv * 65536.0f);
+			job.texture = s.texture;
+			filler.GetTextured(s.texture)(&job);
+		}
+	}
+}
@@ -0,0 +1,69 @@
+/**
+* File : SpanBuffer.h
+* Description : S-buffer, hidden surface removal at the span level
+*
+* Author(s) : ALucchi
+* Date of creation : 17/10/2026
+* Modification(s) :
+*/
+
+#ifndef SPAN_BUFFER_H
+#define SPAN_BUFFER_H
+
+//-------------------------------------------------------------------- INCLUDES
+#include "defs.h"
+#include "TextureManager.h"
+#include "SpanFiller.h"
+
+//---------------------------------------------------------------------- CONSTS
+
+#define SBUFFER_INITIAL_SPANS	4096
+
+//----------------------------------------------------------------------- TYPES
+
+/* Visible part of a textured span. The depth and texture coordinates are
+	linear functions of x : value(x) = value0 + dvalue * x */
+typedef struct
+{
+	short		x1, x2;		// first and last pixel
+	int		next;			// next span on the scanline (-1 = none)
+	float		z0, dz;		// depth (proportional to 1/z, greater is nearer)
+	float		u0, du;		// texture coordinates
+	float		v0, dv;
+	const Texture	*texture;
+} SSpan;
+
+//--------------------------------------------------------------------- CLASSES
+
+/* Keeps, for each scanline, a list of non overlapping spans sorted by x.
+	Spans are clipped against the spans already inserted, so inserting the
+	faces from front to back is the cheapest order. Pixels are only written
+	by Flush, once per frame. */
+class SpanBuffer
+{
+public:
+	SpanBuffer();
+	~SpanBuffer();
+
+	void Clear(void);
+
+	// Insert the span [x1,x2] of the scanline y
+	void Insert(long y, long x1, long x2, float z0, float dz,
+					float u0, float du, float v0, float dv, const Texture *texture);
+
+	// Texture the visible spans with the kernels of filler
+	void Flush(Screen screen, const SpanFiller &filler);
+
+	int GetNumSpans(void) const;
+
+private:
+	int		head[SCR_HEIGHT];	// first span of each scanline
+	SSpan		*spans;				// span pool
+	int		numSpans,			// used spans
+				maxSpans;			// allocated spans
+
+	int newSpan(const SSpan &span, short x1, short x2);
+	void replace(long y, int *prev, int cur, short x1, short x2, const SSpan &span);
+};
+
+#endif // SPAN_BUFFER_H
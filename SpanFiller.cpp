@@ -0,0 +1,440 @@
+/**
+* File : SpanFiller.cpp
+* Description : Span kernels filling runs of pixels of a scanline
+*
+* Author(s) : ALucchi
+* Date of creation : 17/10/2026
+* Modification(s) :
+*/
+
+//-------------------------------------------------------------------- INCLUDES
+#include "Object.h"
+#include "SpanFiller.h"
+#include <time.h>
+
+#ifdef SPAN_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef SPAN_AVX2
+#include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+//--------------------------------------------------------------------- GLOBALS
+
+static const char* kernelNames[SpanFiller::NUM_KERNELS] =
+	{"wrap", "clamp", "wrap tiled", "clamp tiled", "flat"};
+
+//------------------------------------------------------------------- FUNCTIONS
+
+/* Returns true if no texel of the span is outside of the texture. u and v
+	are linear along the span, so their extrema are at its ends. */
+static bool spanInTexture(const SpanJob *job)
+{
+	const Texture *texture = job->texture;
+	long last = job->count - 1;
+
+	long u0 = job->u >> 16, u1 = (job->u + job->du*last) >> 16;
+	long v0 = job->v >> 16, v1 = (job->v + job->dv*last) >> 16;
+
+	return MIN(u0, u1) >= 0 && MAX(u0, u1) < texture->width &&
+			 MIN(v0, v1) >= 0 && MAX(v0, v1) < texture->height;
+}
+
+template <int layout>
+static void texturedWrapScalar(const SpanJob *job)
+{
+	const Texture *texture = job->texture;
+	const byte *data = texture->data;
+	Pixel *dst = job->dst;
+	long u = job->u, v = job->v;
+	long du = job->du, dv = job->dv;
+	long uMask = texture->width - 1, vMask = texture->height - 1;
+	int shift = texture->widthShift;
+
+	for(long i = job->count; i > 0; i--, u+=du, v+=dv)
+		*dst++ = TEXEL_TO_PIXEL(texture, data[LayoutTexelIndex<layout>((u >> 16) & uMask, (v >> 16) & vMask, shift)]);
+}
+
+/* Inside the texture the masks of the wrap kernels have no effect, only the
+	spans leaving the texture are clamped texel by texel */
+template <int layout>
+static void texturedClampScalar(const SpanJob *job)
+{
+	if(spanInTexture(job))
+	{
+		texturedWrapScalar<layout>(job);
+		return;
+	}
+
+	const Texture *texture = job->texture;
+	Pixel *dst = job->dst;
+	long u = job->u, v = job->v;
+	long du = job->du, dv = job->dv;
+
+	for(long i = job->count; i > 0; i--, u+=du, v+=dv)
+		*dst++ = FetchTexelClamp(texture, u, v);
+}
+
+/* Memset (or the loop the compiler vectorizes) is already as fast as it
+	gets, the same kernel is used for all the instruction sets */
+static void flatScalar(const SpanJob *job)
+{
+#if SCR_BPP == 8
+	memset(job->dst, job->color, job->count);
+#else
+	Pixel *dst = job->dst;
+	for(long i = job->count; i > 0; i--)
+		*dst++ = job->color;
+#endif
+}
+
+#ifdef SPAN_SSE2
+template <int layout>
+static inline __m128i texelIndex4(__m128i x, __m128i y, __m128i widthShift)
+{
+	if(layout == TEXTURE_TILED)
+	{
+		__m128i tile = _mm_set1_epi32(~TEXTURE_TILE_MASK);
+		__m128i texel = _mm_set1_epi32(TEXTURE_TILE_MASK);
+		__m128i row = _mm_add_epi32(_mm_sll_epi32(_mm_and_si128(y, tile), widthShift),
+											 _mm_slli_epi32(_mm_and_si128(y, texel), TEXTURE_TILE_SHIFT));
+		__m128i col = _mm_add_epi32(_mm_slli_epi32(_mm_and_si128(x, tile), TEXTURE_TILE_SHIFT),
+											 _mm_and_si128(x, texel));
+		return _mm_add_epi32(row, col);
+	}
+	return _mm_add_epi32(x, _mm_sll_epi32(y, widthShift));
+}
+
+/* 4 texel indices per iteration. The loads stay scalar, SSE2 has no gather.
+	The coordinates are stepped on 32 bits, which keeps the 16 bits of the
+	integer part the masks need. */
+template <int layout>
+static void texturedWrapSSE2(const SpanJob *job)
+{
+	if(job->count < 8)
+	{
+		texturedWrapScalar<layout>(job);
+		return;
+	}
+
+	const Texture *texture = job->texture;
+	const byte *data = texture->data;
+	Pixel *dst = job->dst;
+	long count = job->count;
+	int u = (int)job->u, v = (int)job->v;
+	int du = (int)job->du, dv = (int)job->dv;
+	int index[4];
+
+	__m128i u4 = _mm_setr_epi32(u, u + du, u + 2*du, u + 3*du);
+	__m128i v4 = _mm_setr_epi32(v, v + dv, v + 2*dv, v + 3*dv);
+	__m128i du4 = _mm_set1_epi32(4*du);
+	__m128i dv4 = _mm_set1_epi32(4*dv);
+	__m128i uMask = _mm_set1_epi32(texture->width - 1);
+	__m128i vMask = _mm_set1_epi32(texture->height - 1);
+	__m128i shift = _mm_cvtsi32_si128(texture->widthShift);
+
+	for(; count >= 4; count -= 4, dst += 4)
+	{
+		__m128i idx = texelIndex4<layout>(_mm_and_si128(_mm_srai_epi32(u4, 16), uMask),
+													 _mm_and_si128(_mm_srai_epi32(v4, 16), vMask), shift);
+		_mm_storeu_si128((__m128i*)index, idx);
+
+		dst[0] = TEXEL_TO_PIXEL(texture, data[index[0]]);
+		dst[1] = TEXEL_TO_PIXEL(texture, data[index[1]]);
+		dst[2] = TEXEL_TO_PIXEL(texture, data[index[2]]);
+		dst[3] = TEXEL_TO_PIXEL(texture, data[index[3]]);
+
+		u4 = _mm_add_epi32(u4, du4);
+		v4 = _mm_add_epi32(v4, dv4);
+	}
+
+	long done = job->count - count;
+	SpanJob rest = *job;
+	rest.dst = dst;
+	rest.count = count;
+	rest.u += job->du * done;
+	rest.v += job->dv * done;
+	texturedWrapScalar<layout>(&rest);
+}
+
+template <int layout>
+static void texturedClampSSE2(const SpanJob *job)
+{
+	if(spanInTexture(job))
+		texturedWrapSSE2<layout>(job);
+	else
+		texturedClampScalar<layout>(job);
+}
+#endif //SPAN_SSE2
+
+#ifdef SPAN_AVX2
+template <int layout>
+SPAN_AVX2_TARGET
+static inline __m256i texelIndex8(__m256i x, __m256i y, __m128i widthShift)
+{
+	if(layout == TEXTURE_TILED)
+	{
+		__m256i tile = _mm256_set1_epi32(~TEXTURE_TILE_MASK);
+		__m256i texel = _mm256_set1_epi32(TEXTURE_TILE_MASK);
+		__m256i row = _mm256_add_epi32(_mm256_sll_epi32(_mm256_and_si256(y, tile), widthShift),
+												 _mm256_slli_epi32(_mm256_and_si256(y, texel), TEXTURE_TILE_SHIFT));
+		__m256i col = _mm256_add_epi32(_mm256_slli_epi32(_mm256_and_si256(x, tile), TEXTURE_TILE_SHIFT),
+												 _mm256_and_si256(x, texel));
+		return _mm256_add_epi32(row, col);
+	}
+	return _mm256_add_epi32(x, _mm256_sll_epi32(y, widthShift));
+}
+
+/* 8 texel indices per iteration. At 8 bpp the texels are gathered 4 bytes at
+	a time, the textures are padded for the last ones. */
+template <int layout>
+SPAN_AVX2_TARGET
+static void texturedWrapAVX2(const SpanJob *job)
+{
+	if(job->count < 16)
+	{
+		texturedWrapScalar<layout>(job);
+		return;
+	}
+
+	const Texture *texture = job->texture;
+	const byte *data = texture->data;
+	Pixel *dst = job->dst;
+	long count = job->count;
+	int u = (int)job->u, v = (int)job->v;
+	int du = (int)job->du, dv = (int)job->dv;
+
+	__m256i steps = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256i u8 = _mm256_add_epi32(_mm256_set1_epi32(u), _mm256_mullo_epi32(_mm256_set1_epi32(du), steps));
+	__m256i v8 = _mm256_add_epi32(_mm256_set1_epi32(v), _mm256_mullo_epi32(_mm256_set1_epi32(dv), steps));
+	__m256i du8 = _mm256_set1_epi32(8*du);
+	__m256i dv8 = _mm256_set1_epi32(8*dv);
+	__m256i uMask = _mm256_set1_epi32(texture->width - 1);
+	__m256i vMask = _mm256_set1_epi32(texture->height - 1);
+	__m128i shift = _mm_cvtsi32_si128(texture->widthShift);
+
+#if SCR_BPP == 8
+	// Low byte of each texel to the 4 first bytes of each 128 bits lane
+	__m256i shuffle = _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+												  0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	__m256i pack = _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0);
+#else
+	int index[8];
+#endif
+
+	for(; count >= 8; count -= 8, dst += 8)
+	{
+		__m256i idx = texelIndex8<layout>(_mm256_and_si256(_mm256_srai_epi32(u8, 16), uMask),
+													 _mm256_and_si256(_mm256_srai_epi32(v8, 16), vMask), shift);
+
+		u8 = _mm256_add_epi32(u8, du8);
+		v8 = _mm256_add_epi32(v8, dv8);
+
+#if SCR_BPP == 8
+		__m256i texels = _mm256_i32gather_epi32((const int*)data, idx, 1);
+		texels = _mm256_shuffle_epi8(texels, shuffle);
+		texels = _mm256_permutevar8x32_epi32(texels, pack);
+		_mm_storel_epi64((__m128i*)dst, _mm256_castsi256_si128(texels));
+#else
+		_mm256_storeu_si256((__m256i*)index, idx);
+		for(int i = 0; i < 8; i++)
+			dst[i] = TEXEL_TO_PIXEL(texture, data[index[i]]);
+#endif
+	}
+
+	long done = job->count - count;
+	SpanJob rest = *job;
+	rest.dst = dst;
+	rest.count = count;
+	rest.u += job->du * done;
+	rest.v += job->dv * done;
+	texturedWrapScalar<layout>(&rest);
+}
+
+template <int layout>
+static void texturedClampAVX2(const SpanJob *job)
+{
+	if(spanInTexture(job))
+		texturedWrapAVX2<layout>(job);
+	else
+		texturedClampScalar<layout>(job);
+}
+#endif //SPAN_AVX2
+
+//--------------------------------------------------------------------- CLASSES
+
+SpanFiller::SpanFiller()
+{
+	SetISA(GetBestISA());
+}
+
+void SpanFiller::SetISA(int i)
+{
+	isa = CLAMP(i, SCALAR, GetBestISA());
+	for(int k = 0; k < NUM_KERNELS; k++)
+		kernels[k] = getKernel(k, isa);
+}
+
+int SpanFiller::GetISA(void) const
+{
+	return isa;
+}
+
+/* Textured kernels of the instruction set isa for the specified layout.
+	kernels[0] is the wrap kernel, kernels[1] the clamp kernel. */
+template <int layout>
+static void getTexturedKernels(int isa, SpanKernel *kernels)
+{
+	switch(isa)
+	{
+#ifdef SPAN_AVX2
+		case SpanFiller::AVX2:
+			kernels[0] = texturedWrapAVX2<layout>;
+			kernels[1] = texturedClampAVX2<layout>;
+			break;
+#endif
+#ifdef SPAN_SSE2
+		case SpanFiller::SSE2:
+			kernels[0] = texturedWrapSSE2<layout>;
+			kernels[1] = texturedClampSSE2<layout>;
+			break;
+#endif
+		default:
+			kernels[0] = texturedWrapScalar<layout>;
+			kernels[1] = texturedClampScalar<layout>;
+			break;
+	}
+}
+
+SpanKernel SpanFiller::getKernel(int kernel, int isa)
+{
+	SpanKernel textured[2];
+
+	switch(kernel)
+	{
+		case TEXTURED_WRAP:
+		case TEXTURED_CLAMP:
+			getTexturedKernels<TEXTURE_LINEAR>(isa, textured);
+			return textured[kernel - TEXTURED_WRAP];
+		case TEXTURED_WRAP_TILED:
+		case TEXTURED_CLAMP_TILED:
+			getTexturedKernels<TEXTURE_TILED>(isa, textured);
+			return textured[kernel - TEXTURED_WRAP_TILED];
+		default:
+			return flatScalar;
+	}
+}
+
+int SpanFiller::GetBestISA(void)
+{
+#if defined(SPAN_AVX2) && defined(__GNUC__)
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2"))
+		return AVX2;
+#elif defined(SPAN_AVX2) && defined(_MSC_VER)
+	// AVX2 needs the CPU flag and the OS saving the ymm registers
+	int info[4];
+	__cpuid(info, 1);
+	if((info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6)
+	{
+		__cpuidex(info, 7, 0);
+		if(info[1] & (1 << 5))
+			return AVX2;
+	}
+#endif
+
+#ifdef SPAN_SSE2
+	return SSE2;
+#else
+	return SCALAR;
+#endif
+}
+
+const char* SpanFiller::GetISAName(int isa)
+{
+	switch(isa)
+	{
+		case SCALAR:	return "scalar";
+		case SSE2:		return "sse2";
+		case AVX2:		return "avx2";
+		default:			return "unknown";
+	}
+}
+
+/* Fill screen wide scanlines from a 1024x1024 texture (1 MB at 8 bpp) during
+	a quarter of second for each kernel. The scanlines sweep a square of the
+	texture rotated by several angles, one texel per pixel : at 90 degrees
+	the linear layout touches a new cache line for each pixel. */
+void SpanFiller::Benchmark(void)
+{
+	static const int angles[] = {0, 30, 60, 90};
+	static const int numAngles = sizeof(angles) / sizeof(angles[0]);
+
+	Texture *texture = new Texture();
+	texture->width = 1024;
+	texture->height = 1024;
+	texture->widthShift = 10;
+	texture->heightShift = 10;
+	texture->size = texture->width * texture->height;
+	texture->address = TEXTURE_WRAP;
+	texture->data = new byte[texture->size + TEXTURE_PADDING];
+	for(int i = 0; i < texture->size + TEXTURE_PADDING; i++)
+		texture->data[i] = (byte)(i * 7);
+	for(int i = 0; i < 256; i++)
+		texture->palette[i] = RGB_TO_PIXEL(i, i, i);
+
+	Pixel *line = new Pixel[SCR_WIDTH];
+
+	SpanJob job;
+	job.dst = line;
+	job.count = SCR_WIDTH;
+	job.texture = texture;
+	job.color = 0;
+
+	for(int k = 0; k < NUM_KERNELS; k++)
+	{
+		bool tiled = (k == TEXTURED_WRAP_TILED || k == TEXTURED_CLAMP_TILED);
+		texture->layout = tiled ? TEXTURE_TILED : TEXTURE_LINEAR;
+
+		for(int i = SCALAR; i <= GetBestISA(); i++)
+		{
+			SpanKernel kernel = getKernel(k, i);
+
+			for(int a = 0; a < (k == FLAT ? 1 : numAngles); a++)
+			{
+				float c = (float)cos(angles[a] * RAD);
+				float s = (float)sin(angles[a] * RAD);
+				job.du = (long)(c * 65536.0f);
+				job.dv = (long)(s * 65536.0f);
+
+				long spans = 0;
+				clock_t start = clock(), end;
+
+				do
+				{
+					// Rows of the square, centered on the texture
+					for(int n = 0; n < 256; n++)
+					{
+						float row = (float)(n - 128);
+						job.u = (long)((512.0f - c*SCR_WIDTH/2 - s*row) * 65536.0f);
+						job.v = (long)((512.0f - s*SCR_WIDTH/2 + c*row) * 65536.0f);
+						kernel(&job);
+					}
+					spans += 256;
+					end = clock();
+				} while(end - start < CLOCKS_PER_SEC / 4);
+
+				double seconds = (double)(end - start) / CLOCKS_PER_SEC;
+				printf("Span kernel %-11s %-6s %2d deg : %8.1f Mpixels/s\n", kernelNames[k],
+						 GetISAName(i), angles[a], (double)spans * SCR_WIDTH / seconds / 1000000.0);
+			}
+		}
+	}
+
+	delete[] line;
+	delete[] texture->data;
+	delete texture;
+}
@@ -0,0 +1,165 @@
+/**
+* File : SpanFiller.h
+* Description : Span kernels filling runs of pixels of a scanline
+*
+* Author(s) : ALucchi
+* Date of creation : 17/10/2026
+* Modification(s) :
+*/
+
+#ifndef SPAN_FILLER_H
+#define SPAN_FILLER_H
+
+//-------------------------------------------------------------------- INCLUDES
+#include "defs.h"
+#include "TextureManager.h"
+
+//---------------------------------------------------------------------- CONSTS
+
+// SIMD kernels are compiled on x86 only, the scalar kernels are always there
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define SPAN_SSE2
+	#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+		#define SPAN_AVX2
+		#define SPAN_AVX2_TARGET	__attribute__((target("avx2")))
+	#elif defined(_MSC_VER) && _MSC_VER >= 1700
+		#define SPAN_AVX2
+		#define SPAN_AVX2_TARGET
+	#endif
+#endif
+
+// Texels are palette indices
+#if SCR_BPP == 8
+	#define TEXEL_TO_PIXEL(texture, texel)	(texel)
+#else
+	#define TEXEL_TO_PIXEL(texture, texel)	((texture)->palette[texel])
+#endif
+
+//----------------------------------------------------------------------- TYPES
+
+/* A run of count pixels starting at dst. u and v are the texel coordinates of
+	the first pixel (16.16 fixed point), du and dv their steps for one pixel. */
+typedef struct
+{
+	Pixel		*dst;
+	long		count;
+	long		u, v;
+	long		du, dv;
+	const Texture	*texture;
+	Pixel		color;				// FLAT only
+} SpanJob;
+
+typedef void (*SpanKernel)(const SpanJob *job);
+
+//--------------------------------------------------------------------- CLASSES
+
+/* Set of span kernels for the pixel format of the screen (SCR_BPP). The
+	kernels of the best instruction set supported by the CPU are selected at
+	construction. Kernels are chosen once per face, so the pixel loops don't
+	test the rendering mode. */
+class SpanFiller
+{
+public:
+	enum KERNEL {
+		TEXTURED_WRAP,		// texture lookup, no depth test
+		TEXTURED_CLAMP,
+		TEXTURED_WRAP_TILED,	// same for the TEXTURE_TILED layout
+		TEXTURED_CLAMP_TILED,
+		FLAT,					// single color (wireframe overlay)
+		NUM_KERNELS};
+
+	enum ISA {
+		SCALAR,
+		SSE2,
+		AVX2,
+		NUM_ISAS};
+
+	SpanFiller();
+
+	// isa is lowered to the best instruction set supported
+	void SetISA(int isa);
+	int GetISA(void) const;
+
+	inline SpanKernel Get(int kernel) const
+	{
+		return kernels[kernel];
+	}
+
+	// Textured kernel for the address mode and the layout of texture
+	inline SpanKernel GetTextured(const Texture *texture) const
+	{
+		int kernel = texture->address == TEXTURE_CLAMP ? TEXTURED_CLAMP : TEXTURED_WRAP;
+		if(texture->layout == TEXTURE_TILED)
+			kernel += TEXTURED_WRAP_TILED - TEXTURED_WRAP;
+		return kernels[kernel];
+	}
+
+	static int GetBestISA(void);
+	static const char* GetISAName(int isa);
+
+	/* Print the fill rate of each kernel for each instruction set, with the
+		spans rotated in the texture */
+	static void Benchmark(void);
+
+private:
+	int			isa;
+	SpanKernel	kernels[NUM_KERNELS];
+
+	static SpanKernel getKernel(int kernel, int isa);
+};
+
+//------------------------------------------------------------------- FUNCTIONS
+
+// Texel of texture at (u,v) (16.16 fixed point) in the screen format
+inline Pixel FetchTexelWrap(const Texture *texture, long u, long v)
+{
+	long x = (u >> 16) & (texture->width - 1);
+	long y = (v >> 16) & (texture->height - 1);
+	return TEXEL_TO_PIXEL(texture, texture->data[TexelIndex(texture, x, y)]);
+}
+
+inline Pixel FetchTexelClamp(const Texture *texture, long u, long v)
+{
+	long x = MIN(MAX(u >> 16, 0L), (long)texture->width - 1);
+	long y = MIN(MAX(v >> 16, 0L), (long)texture->height - 1);
+	return TEXEL_TO_PIXEL(texture, texture->data[TexelIndex(texture, x, y)]);
+}
+
+inline Pixel FetchTexel(const Texture *texture, long u, long v)
+{
+	if(texture->address == TEXTURE_CLAMP)
+		return FetchTexelClamp(texture, u, v);
+	return FetchTexelWrap(texture, u, v);
+}
+
+/* The kernels are instantiated for each TEXTURE_LAYOUT, so the addressing
+	is resolved at compile time. See TexelIndex. */
+template <int layout>
+inline long LayoutTexelIndex(long x, long y, int widthShift)
+{
+	if(layout == TEXTURE_TILED)
+		return ((y & ~TEXTURE_TILE_MASK) << widthShift) + ((x & ~TEXTURE_TILE_MASK) << TEXTURE_TILE_SHIFT) +
+				 ((y & TEXTURE_TILE_MASK) << TEXTURE_TILE_SHIFT) + (x & TEXTURE_TILE_MASK);
+	return x + (y << widthShift);
+}
+
+/* FetchTexel for the address mode and the layout known at compile time, for
+	the pixel loops which can't use the kernels (depth tested pixels) */
+template <int address, int layout>
+inline Pixel FetchTexelAs(const Texture *texture, long u, long v)
+{
+	long x, y;
+	if(address == TEXTURE_CLAMP)
+	{
+		x = MIN(MAX(u >> 16, 0L), (long)texture->width - 1);
+		y = MIN(MAX(v >> 16, 0L), (long)texture->height - 1);
+	}
+	else
+	{
+		x = (u >> 16) & (texture->width - 1);
+		y = (v >> 16) & (texture->height - 1);
+	}
+	return TEXEL_TO_PIXEL(texture, texture->data[LayoutTexelIndex<layout>(x, y, texture->widthShift)]);
+}
+
+#endif // SPAN_FILLER_H
@@ -25,10 +25,12 @@ TextureManager *TextureManager::m_instance = 0; // instance
 TextureManager::TextureManager()
 {
 	m_NumTextures = 0;
+	m_Layout = TEXTURE_LINEAR;
 }
 
 TextureManager::~TextureManager()
 {
+	FreeAll();
 }
 
 TextureManager &TextureManager::Instance()
@@ -122,12 +124,14 @@ int TextureManager::LoadBitmapFile (const char *fileName)
 		return ERR_LOADING_BMP;
 
 	//strcpy(currentTexture->name,"default");;
-	currentTexture->data=new unsigned char[sizeBmp];
+	currentTexture->data=new unsigned char[sizeBmp+TEXTURE_PADDING];
 	ptrTex=currentTexture->data;
 	currentTexture->width=width;
 	currentTexture->height=height;
 	currentTexture->size=width*height;
 	currentTexture->bpp=bpp;
+	currentTexture->address=TEXTURE_WRAP;
+	currentTexture->layout=TEXTURE_LINEAR;
 	
 	// Set Color table
 	/*
@@ -153,6 +157,17 @@ int TextureManager::LoadBitmapFile (const char *fileName)
 		ptrCol++;
 	}
 
+	// Texels are palette indices, convert the palette to the screen format
+	for(int i=0;i<256;i++)
+	{
+#if SCR_BPP == 8
+		currentTexture->palette[i] = i;
+#else
+		ptrCol = &currentTexture->colorTable[i*4];
+		currentTexture->palette[i] = RGB_TO_PIXEL((Pixel)ptrCol[0], (Pixel)ptrCol[1], (Pixel)ptrCol[2]);
+#endif
+	}
+
 	fread(bmp,1,sizeBmp,f);
 
 #define FLIP_Y_COPY
@@ -180,15 +195,171 @@ int TextureManager::LoadBitmapFile (const char *fileName)
 
 	delete[] sBmp;
 	fclose(f);
+
+	ResizeToPowerOfTwo(currentTexture);
+	BuildMipmaps(currentTexture);
+	ConvertLayout(currentTexture, m_Layout);
 	return currentTexture->id;
 }
 
+/* Build the mip chain of the specified texture, down to 1x1. Each texel is
+	the average (box filter) of the 2x2 texels above it. Texels are palette
+	indices : the average color is mapped back to the nearest color of the
+	palette. The search is done once per color on 18 bits and memorized. */
+void TextureManager::BuildMipmaps(Texture* texture)
+{
+	texture->mipmap=NULL;
+	if(texture->bpp != 8)
+		return;
+
+	short* nearest=new short[1 << 18];
+	memset(nearest, -1, (1 << 18)*sizeof(short));
+
+	Texture* level=texture;
+	while(level->width > 1 || level->height > 1)
+	{
+		Texture* next=new Texture(*level);
+		next->widthShift=MAX(level->widthShift-1, 0);
+		next->heightShift=MAX(level->heightShift-1, 0);
+		next->width=1 << next->widthShift;
+		next->height=1 << next->heightShift;
+		next->size=next->width*next->height;
+		next->data=new byte[next->size+TEXTURE_PADDING];
+		memset(&next->data[next->size], 0, TEXTURE_PADDING);
+
+		// 1 texel wide (or high) levels only average 2 texels
+		int dx=level->width > 1 ? 1 : 0;
+		int dy=level->height > 1 ? level->width : 0;
+
+		for(int y=0;y<next->height;y++)
+		{
+			for(int x=0;x<next->width;x++)
+			{
+				const byte* src=&level->data[(x << dx) + (y << (dy ? 1 : 0))*level->width];
+				const byte* texels[4]={&texture->colorTable[src[0]*4], &texture->colorTable[src[dx]*4],
+											  &texture->colorTable[src[dy]*4], &texture->colorTable[src[dx+dy]*4]};
+				int r=0, g=0, b=0;
+				for(int i=0;i<4;i++)
+				{
+					r+=texels[i][0];
+					g+=texels[i][1];
+					b+=texels[i][2];
+				}
+				r=(r+2)/4;
+				g=(g+2)/4;
+				b=(b+2)/4;
+
+				int color=((r >> 2) << 12) | ((g >> 2) << 6) | (b >> 2);
+				if(nearest[color] < 0)
+				{
+					int bestDist=0x7FFFFFFF;
+					for(int c=0;c<256;c++)
+					{
+						const byte* col=&texture->colorTable[c*4];
+						int dist=(col[0]-r)*(col[0]-r) + (col[1]-g)*(col[1]-g) + (col[2]-b)*(col[2]-b);
+						if(dist < bestDist)
+						{
+							bestDist=dist;
+							nearest[color]=c;
+						}
+					}
+				}
+				next->data[x+y*next->width]=(byte)nearest[color];
+			}
+		}
+
+		level->mipmap=next;
+		level=next;
+	}
+
+	delete[] nearest;
+}
+
+/* Reorder the texels of every level of the specified texture. In the tiled
+	layout a span crossing the texture diagonally stays in the same cache
+	line for several texels. */
+void TextureManager::ConvertLayout(Texture* texture, int layout)
+{
+	for(Texture* level=texture; level; level=level->mipmap)
+	{
+		int newLayout=layout;
+		if(level->width < (1 << TEXTURE_TILE_SHIFT) || level->height < (1 << TEXTURE_TILE_SHIFT))
+			newLayout=TEXTURE_LINEAR;
+		if(newLayout == level->layout)
+			continue;
+
+		byte* data=new byte[level->size+TEXTURE_PADDING];
+		memset(&data[level->size], 0, TEXTURE_PADDING);
+
+		Texture converted=*level;
+		converted.layout=newLayout;
+		for(int y=0;y<level->height;y++)
+			for(int x=0;x<level->width;x++)
+				data[TexelIndex(&converted, x, y)]=level->data[TexelIndex(level, x, y)];
+
+		delete[] level->data;
+		level->data=data;
+		level->layout=newLayout;
+	}
+}
+
+/* The samplers address the texels with shifts and masks, so the dimensions
+	of the textures must be powers of two. The other textures are resampled
+	(nearest texel) to the next power of two : the texture coordinates of the
+	meshes are normalized, the mapping doesn't change. */
+void TextureManager::ResizeToPowerOfTwo(Texture* texture)
+{
+	int widthShift=0, heightShift=0;
+	while((1 << widthShift) < texture->width)
+		widthShift++;
+	while((1 << heightShift) < texture->height)
+		heightShift++;
+
+	int width=1 << widthShift;
+	int height=1 << heightShift;
+
+	if(width != texture->width || height != texture->height)
+	{
+		byte* data=new byte[width*height+TEXTURE_PADDING];
+		for(int y=0;y<height;y++)
+		{
+			const byte* src=&texture->data[(y*texture->height/height)*texture->width];
+			for(int x=0;x<width;x++)
+				data[x+y*width]=src[x*texture->width/width];
+		}
+
+		delete[] texture->data;
+		texture->data=data;
+		texture->width=width;
+		texture->height=height;
+		texture->size=width*height;
+	}
+
+	texture->widthShift=widthShift;
+	texture->heightShift=heightShift;
+	memset(&texture->data[texture->size], 0, TEXTURE_PADDING);
+}
+
+/* Free the specified texture and its mip levels. Its id stays reserved,
+	GetTexture returns NULL for it. */
 void TextureManager::FreeTexture (int nID)
 {
+	Texture* texture = GetTexture(nID);
+	while(texture)
+	{
+		Texture* next = texture->mipmap;
+		delete[] texture->data;
+		delete texture;
+		texture = next;
+	}
+	if(nID >= 0 && nID < m_NumTextures)
+		m_pTextures[nID] = NULL;
 }
 
 void TextureManager::FreeAll ()
 {
+	for(int i = 0; i < m_NumTextures; i++)
+		FreeTexture(i);
 }
 
 Texture* TextureManager::GetNewTexture()
@@ -213,6 +384,14 @@ int TextureManager::LoadPalette(int textureID)
 		return ERR_LOADING_PALETTE;
 }
 
+// NULL if textureID is not the id of a texture
+Texture* TextureManager::GetTexture(int textureID)
+{
+	if(textureID < 0 || textureID >= m_NumTextures)
+		return NULL;
+	return m_pTextures[textureID];
+}
+
 int TextureManager::LoadTexture(int textureID)
 {
 	//Display* display = Application::Instance().GetDisplay();
@@ -222,6 +401,29 @@ int TextureManager::LoadTexture(int textureID)
 		Application::Instance().GetRenderer()->SetCurrentTexture(texture);
 	else
 		return ERR_LOADING_TEXTURE;
+	return 0;
+}
+
+void TextureManager::SetLayout(int layout)
+{
+	m_Layout = layout;
+	for(int i = 0; i < m_NumTextures; i++)
+		ConvertLayout(m_pTextures[i], layout);
+}
+
+int TextureManager::GetLayout(void) const
+{
+	return m_Layout;
+}
+
+int TextureManager::SetAddressMode(int textureID, int mode)
+{
+	Texture* texture = GetTexture(textureID);
+	if(!texture)
+		return ERR_LOADING_TEXTURE;
+	for(; texture; texture = texture->mipmap)
+		texture->address = mode;
+	return 0;
 }
 
 /*
@@ -15,17 +15,44 @@
 
 using namespace std;
 
+//---------------------------------------------------------------------- CONSTS
+
+// Bytes readable after the last texel (SIMD kernels load 4 texels at once)
+#define TEXTURE_PADDING		4
+
+// Tiles of 8x8 texels, a cache line at 8 bpp (TEXTURE_TILED)
+#define TEXTURE_TILE_SHIFT	3
+#define TEXTURE_TILE_MASK	((1 << TEXTURE_TILE_SHIFT) - 1)
+
 //----------------------------------------------------------------------- TYPES
 
-typedef struct {
+// Texel addressing outside of [0,width[x[0,height[
+enum TEXTURE_ADDRESS {
+	TEXTURE_WRAP,		// the texture is repeated
+	TEXTURE_CLAMP		// the texels of the border are repeated
+};
+
+// Order of the texels in memory
+enum TEXTURE_LAYOUT {
+	TEXTURE_LINEAR,	// row after row
+	TEXTURE_TILED		// tile after tile, each tile row after row
+};
+
+typedef struct Texture {
 	//char		name[32];	//texture name
 	int		id;
-	int		width;		//dimensions
+	int		width;		//dimensions (powers of two)
 	int		height;
+	int		widthShift;	//log2(width)
+	int		heightShift;	//log2(height)
 	int		bpp;
 	int		size;			//width * height
+	int		address;		//TEXTURE_ADDRESS
+	int		layout;		//TEXTURE_LAYOUT
 	byte		colorTable[SIZE_BMP_PALETTE_8BITS];
+	Pixel		palette[256];	//colorTable in the screen format
 	byte		*data;		//data
+	struct Texture	*mipmap;	//next level, half the size (NULL = none)
 } Texture;
 
 //--------------------------------------------------------------------- CLASSES
@@ -41,6 +68,12 @@ public :
 	int AddTexture(const char *szFilename);
 	int LoadPalette(int textureID);
 	int LoadTexture(int textureID);
+	Texture* GetTexture(int textureID);
+	int SetAddressMode(int textureID, int mode);
+
+	// Layout of the textures loaded and of the textures already loaded
+	void SetLayout(int layout);
+	int GetLayout(void) const;
 
 	void FreeTexture (int nID);
 	void FreeAll();
@@ -51,6 +84,9 @@ private :
 	static TextureManager *m_instance;
 
 	int LoadBitmapFile (const char *fileName);
+	void ResizeToPowerOfTwo(Texture* texture);
+	void BuildMipmaps(Texture* texture);
+	void ConvertLayout(Texture* texture, int layout);
 
 	/*
 	UBYTE *LoadBitmapFile (const char *filename, int &nWidth, int &nHeight, int &nBPP);
@@ -61,7 +97,21 @@ private :
 
 private :
 	int m_NumTextures;
+	int m_Layout;
 	vector<Texture*> m_pTextures;
 };
 
+//------------------------------------------------------------------- FUNCTIONS
+
+/* Offset of the texel (x,y) in the data of texture. x and y must be inside
+	the texture. Levels smaller than a tile are always linear. */
+inline long TexelIndex(const Texture *texture, long x, long y)
+{
+	if(texture->layout == TEXTURE_TILED)
+		return ((y & ~TEXTURE_TILE_MASK) << texture->widthShift) +
+				 ((x & ~TEXTURE_TILE_MASK) << TEXTURE_TILE_SHIFT) +
+				 ((y & TEXTURE_TILE_MASK) << TEXTURE_TILE_SHIFT) + (x & TEXTURE_TILE_MASK);
+	return x + (y << texture->widthShift);
+}
+
 #endif //TEXTURE_MANAGER_H
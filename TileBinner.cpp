@@ -0,0 +1,255 @@
+/**
+* File : TileBinner.cpp
+* Description : Tiled rasterization of the faces of a frame on several threads
+*
+* Author(s) : ALucchi
+* Date of creation : 17/10/2026
+* Modification(s) :
+*/
+
+//-------------------------------------------------------------------- INCLUDES
+#include "TileBinner.h"
+
+#ifndef WIN32
+#include <unistd.h>
+#endif
+
+//--------------------------------------------------------------------- CLASSES
+
+TileBinner::TileBinner(Renderer *r)
+{
+	renderer = r;
+	numThreads = 0;
+
+#ifdef USE_SDL
+	startSem = NULL;
+	doneSem = NULL;
+	tileMutex = NULL;
+	nextTile = 0;
+	quit = false;
+#endif
+}
+
+TileBinner::~TileBinner()
+{
+	SetNumThreads(0);
+}
+
+int TileBinner::GetNumCPUs(void)
+{
+	int num = 1;
+#ifdef WIN32
+	const char *env = getenv("NUMBER_OF_PROCESSORS");
+	if(env)
+		num = atoi(env);
+#else
+	num = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return CLAMP(num, 1, MAX_RASTER_THREADS);
+}
+
+void TileBinner::SetNumThreads(int num)
+{
+	num = CLAMP(num, 0, MAX_RASTER_THREADS);
+	if(num == numThreads)
+		return;
+
+#ifdef USE_SDL
+	stopWorkers();
+	numThreads = num;
+	startWorkers();
+#else
+	// No thread support, the tiles are rendered by the main thread
+	numThreads = num;
+#endif
+}
+
+int TileBinner::GetNumThreads(void) const
+{
+	return numThreads;
+}
+
+void TileBinner::Clear(void)
+{
+	// clear() keeps the memory, no allocation once the sizes are reached
+	faces.clear();
+	spans.clear();
+	for(int i = 0; i < NUM_TILES; i++)
+		bins[i].clear();
+}
+
+void TileBinner::AddFace(const RasterFace &face, const HSpan *rows)
+{
+	BinnedFace binned;
+	binned.face = face;
+	binned.firstSpan = -1;
+
+	long minX = SCR_WIDTH, maxX = -1;
+	if(face.core == Renderer::RASTER_HALFSPACE)
+	{
+		// No spans, the bounding box was computed by the setup
+		minX = face.minX;
+		maxX = face.maxX;
+	}
+	else
+	{
+		// Copy the spans and compute the bounding box of the face
+		binned.firstSpan = spans.size();
+		int numRows = face.maxY - face.minY;
+		spans.insert(spans.end(), rows, rows + numRows);
+		for(int i = 0; i < numRows; i++)
+		{
+			if(rows[i].xStart <= rows[i].xEnd)
+			{
+				if(rows[i].xStart < minX)
+					minX = rows[i].xStart;
+				if(rows[i].xEnd > maxX)
+					maxX = rows[i].xEnd;
+			}
+		}
+
+		if(maxX < minX)
+		{
+			spans.resize(binned.firstSpan);
+			return;
+		}
+	}
+
+	int index = faces.size();
+	faces.push_back(binned);
+
+	for(int ty = face.minY / TILE_SIZE; ty <= (face.maxY - 1) / TILE_SIZE; ty++)
+	{
+		for(int tx = minX / TILE_SIZE; tx <= maxX / TILE_SIZE; tx++)
+		{
+			bins[ty * NUM_TILES_X + tx].push_back(index);
+		}
+	}
+}
+
+void TileBinner::rasterizeTile(int tile)
+{
+	long x1 = (tile % NUM_TILES_X) * TILE_SIZE;
+	long y1 = (tile / NUM_TILES_X) * TILE_SIZE;
+	long x2 = x1 + TILE_SIZE - 1;
+	long y2 = y1 + TILE_SIZE - 1;
+
+	if(x2 >= SCR_WIDTH)
+		x2 = SCR_WIDTH - 1;
+	if(y2 >= SCR_HEIGHT)
+		y2 = SCR_HEIGHT - 1;
+
+	const vector<int> &bin = bins[tile];
+	for(unsigned int i = 0; i < bin.size(); i++)
+	{
+		const BinnedFace &binned = faces[bin[i]];
+		const HSpan *rows = binned.firstSpan >= 0 ? &spans[binned.firstSpan] : NULL;
+		renderer->rasterizeRect(&binned.face, rows, x1, y1, x2, y2);
+	}
+}
+
+/* Render tiles until there are none left. Called by the main thread and the
+	workers */
+void TileBinner::rasterizeTiles(void)
+{
+#ifdef USE_SDL
+	if(numThreads > 1)
+	{
+		for(;;)
+		{
+			SDL_LockMutex(tileMutex);
+			int tile = nextTile++;
+			SDL_UnlockMutex(tileMutex);
+
+			if(tile >= NUM_TILES)
+				break;
+			if(!bins[tile].empty())
+				rasterizeTile(tile);
+		}
+		return;
+	}
+#endif
+
+	for(int tile = 0; tile < NUM_TILES; tile++)
+	{
+		if(!bins[tile].empty())
+			rasterizeTile(tile);
+	}
+}
+
+void TileBinner::Flush(void)
+{
+	if(faces.empty())
+		return;
+
+#ifdef USE_SDL
+	if(numThreads > 1)
+	{
+		nextTile = 0;
+		for(int i = 0; i < numThreads - 1; i++)
+			SDL_SemPost(startSem);
+
+		rasterizeTiles();
+
+		for(int i = 0; i < numThreads - 1; i++)
+			SDL_SemWait(doneSem);
+	}
+	else
+#endif
+	{
+		rasterizeTiles();
+	}
+
+	Clear();
+}
+
+#ifdef USE_SDL
+int TileBinner::workerMain(void *data)
+{
+	TileBinner *binner = (TileBinner*)data;
+
+	for(;;)
+	{
+		SDL_SemWait(binner->startSem);
+		if(binner->quit)
+			break;
+
+		binner->rasterizeTiles();
+		SDL_SemPost(binner->doneSem);
+	}
+	return 0;
+}
+
+void TileBinner::startWorkers(void)
+{
+	if(numThreads < 2)
+		return;
+
+	quit = false;
+	startSem = SDL_CreateSemaphore(0);
+	doneSem = SDL_CreateSemaphore(0);
+	tileMutex = SDL_CreateMutex();
+
+	for(int i = 0; i < numThreads - 1; i++)
+		workers[i] = SDL_CreateThread(workerMain, this);
+}
+
+void TileBinner::stopWorkers(void)
+{
+	if(numThreads < 2)
+		return;
+
+	quit = true;
+	for(int i = 0; i < numThreads - 1; i++)
+		SDL_SemPost(startSem);
+	for(int i = 0; i < numThreads - 1; i++)
+		SDL_WaitThread(workers[i], NULL);
+
+	SDL_DestroySemaphore(startSem);
+	SDL_DestroySemaphore(doneSem);
+	SDL_DestroyMutex(tileMutex);
+	startSem = NULL;
+	doneSem = NULL;
+	tileMutex = NULL;
+}
+#endif
@@ -0,0 +1,84 @@
+/**
+* File : TileBinner.h
+* Description : Tiled rasterization of the faces of a frame on several threads
+*
+* Author(s) : ALucchi
+* Date of creation : 17/10/2026
+* Modification(s) :
+*/
+
+#ifndef TILE_BINNER_H
+#define TILE_BINNER_H
+
+//-------------------------------------------------------------------- INCLUDES
+#include "defs.h"
+#include "Renderer.h"
+#include <vector>
+
+using namespace std;
+
+//---------------------------------------------------------------------- CONSTS
+
+#define TILE_SIZE			32
+#define NUM_TILES_X		((SCR_WIDTH + TILE_SIZE - 1) / TILE_SIZE)
+#define NUM_TILES_Y		((SCR_HEIGHT + TILE_SIZE - 1) / TILE_SIZE)
+#define NUM_TILES			(NUM_TILES_X * NUM_TILES_Y)
+
+#define MAX_RASTER_THREADS	16
+
+//----------------------------------------------------------------------- TYPES
+
+typedef struct
+{
+	RasterFace	face;
+	int			firstSpan;			// index of the span of face.minY (-1 = no spans)
+} BinnedFace;
+
+//--------------------------------------------------------------------- CLASSES
+
+/* Faces set up by the Renderer are stored for the whole frame and binned in
+	the screen tiles they overlap. Flush renders the tiles in parallel. Each
+	bin keeps the submission order of the faces, so the result is the same
+	as rendering the faces one after the other. */
+class TileBinner
+{
+public:
+	TileBinner(Renderer *renderer);
+	~TileBinner();
+
+	// 0 disables the binning, otherwise the main thread + num-1 workers
+	void SetNumThreads(int num);
+	int GetNumThreads(void) const;
+
+	void Clear(void);
+	void AddFace(const RasterFace &face, const HSpan *rows);
+	void Flush(void);
+
+	static int GetNumCPUs(void);
+
+private:
+	Renderer		*renderer;
+	int			numThreads;
+
+	vector<BinnedFace>	faces;			// faces of the frame
+	vector<HSpan>			spans;			// spans of the faces
+	vector<int>				bins[NUM_TILES];	// face indices of each tile
+
+	void rasterizeTile(int tile);
+	void rasterizeTiles(void);
+
+#ifdef USE_SDL
+	SDL_Thread	*workers[MAX_RASTER_THREADS];
+	SDL_sem		*startSem,			// posted once per worker to start a frame
+					*doneSem;			// posted by each worker at the end
+	SDL_mutex	*tileMutex;			// protects nextTile
+	int			nextTile;			// next tile to render
+	bool			quit;
+
+	static int workerMain(void *data);
+	void startWorkers(void);
+	void stopWorkers(void);
+#endif
+};
+
+#endif // TILE_BINNER_H
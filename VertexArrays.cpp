@@ -0,0 +1,224 @@
+/**
+* File : VertexArrays.cpp
+* Description : Vertices of a mesh stored as one array per component
+*
+* Author(s) : ALucchi
+* Date of creation : 17/10/2026
+* Modification(s) :
+*/
+
+//-------------------------------------------------------------------- INCLUDES
+#include "VertexArrays.h"
+
+//---------------------------------------------------------------------- CONSTS
+
+#ifdef FIXED_PIPELINE
+	#define NUM_ARRAYS	24
+#else
+	#define NUM_ARRAYS	14
+#endif
+
+//--------------------------------------------------------------------- CLASSES
+
+VertexArrays::VertexArrays(void)
+{
+	block = NULL;
+	Free();
+}
+
+VertexArrays::~VertexArrays(void)
+{
+	Free();
+}
+
+void VertexArrays::Alloc(int num)
+{
+	Free();
+
+	// Multiple of the alignment, in elements (floats and ints have the same size)
+	int align = VERTEX_ARRAYS_ALIGN / sizeof(float);
+	stride = (num + align - 1) & ~(align - 1);
+	numVerts = num;
+
+	block = new char[NUM_ARRAYS * stride * sizeof(float) + VERTEX_ARRAYS_ALIGN - 1];
+	float *p = (float*)(((size_t)block + VERTEX_ARRAYS_ALIGN - 1) & ~(size_t)(VERTEX_ARRAYS_ALIGN - 1));
+
+	x = p;	p += stride;
+	y = p;	p += stride;
+	z = p;	p += stride;
+	nx = p;	p += stride;
+	ny = p;	p += stride;
+	nz = p;	p += stride;
+	u = p;	p += stride;
+	v = p;	p += stride;
+	wx = p;	p += stride;
+	wy = p;	p += stride;
+	wz = p;	p += stride;
+	sx = p;	p += stride;
+	sy = p;	p += stride;
+	clip = (int*)p;
+
+#ifdef FIXED_PIPELINE
+	int *f = clip + stride;
+	fx = f;	f += stride;
+	fy = f;	f += stride;
+	fz = f;	f += stride;
+	fu = f;	f += stride;
+	fv = f;	f += stride;
+	fwx = f;	f += stride;
+	fwy = f;	f += stride;
+	fwz = f;	f += stride;
+	fsx = f;	f += stride;
+	fsy = f;
+#endif
+}
+
+void VertexArrays::Free(void)
+{
+	delete[] block;
+	block = NULL;
+
+	numVerts = 0;
+	stride = 0;
+	x = y = z = NULL;
+	nx = ny = nz = NULL;
+	u = v = NULL;
+	wx = wy = wz = NULL;
+	sx = sy = NULL;
+	clip = NULL;
+#ifdef FIXED_PIPELINE
+	fx = fy = fz = NULL;
+	fu = fv = NULL;
+	fwx = fwy = fwz = NULL;
+	fsx = fsy = NULL;
+#endif
+}
+
+void VertexArrays::Reserve(int num)
+{
+	if(num <= stride)
+		return;
+
+	VertexArrays old;
+	old.numVerts = numVerts;
+	old.block = block;
+	old.x = x;	old.y = y;	old.z = z;
+	old.nx = nx;	old.ny = ny;	old.nz = nz;
+	old.u = u;	old.v = v;
+
+	block = NULL;
+	Alloc(num);
+	numVerts = old.numVerts;
+
+	size_t size = numVerts * sizeof(float);
+	memcpy(x, old.x, size);
+	memcpy(y, old.y, size);
+	memcpy(z, old.z, size);
+	memcpy(nx, old.nx, size);
+	memcpy(ny, old.ny, size);
+	memcpy(nz, old.nz, size);
+	memcpy(u, old.u, size);
+	memcpy(v, old.v, size);
+}
+
+void VertexArrays::ClearInputs(void)
+{
+	size_t size = numVerts * sizeof(float);
+	memset(x, 0, size);
+	memset(y, 0, size);
+	memset(z, 0, size);
+	memset(nx, 0, size);
+	memset(ny, 0, size);
+	memset(nz, 0, size);
+	memset(u, 0, size);
+	memset(v, 0, size);
+}
+
+void VertexArrays::Finish(void)
+{
+#ifdef FIXED_PIPELINE
+	for(int i = 0; i < numVerts; i++)
+	{
+		fx[i] = Fixed16(x[i]).raw;
+		fy[i] = Fixed16(y[i]).raw;
+		fz[i] = Fixed16(z[i]).raw;
+		fu[i] = Fixed16(u[i]).raw;
+		fv[i] = Fixed16(v[i]).raw;
+	}
+#endif
+
+	// The padding is transformed too, keep it finite
+	for(int i = numVerts; i < stride; i++)
+	{
+		x[i] = y[i] = 0;
+		z[i] = 1;
+#ifdef FIXED_PIPELINE
+		fx[i] = fy[i] = 0;
+		fz[i] = Fixed16::ONE;
+#endif
+	}
+}
+
+void VertexArrays::Set(const Vertex *verts, int num)
+{
+	Alloc(num);
+	for(int i = 0; i < num; i++)
+		SetVertex(i, verts[i]);
+	Finish();
+}
+
+void VertexArrays::SetVertex(int index, const Vertex &vertex)
+{
+	x[index] = vertex.coordsLocal.x;
+	y[index] = vertex.coordsLocal.y;
+	z[index] = vertex.coordsLocal.z;
+	nx[index] = vertex.normal.x;
+	ny[index] = vertex.normal.y;
+	nz[index] = vertex.normal.z;
+	u[index] = vertex.texCoord.u;
+	v[index] = vertex.texCoord.v;
+}
+
+void VertexArrays::CopyRaster(int dst, const VertexArrays &src, int index)
+{
+	u[dst] = src.u[index];
+	v[dst] = src.v[index];
+	wx[dst] = src.wx[index];
+	wy[dst] = src.wy[index];
+	wz[dst] = src.wz[index];
+	sx[dst] = src.sx[index];
+	sy[dst] = src.sy[index];
+	clip[dst] = src.clip[index];
+#ifdef FIXED_PIPELINE
+	fu[dst] = src.fu[index];
+	fv[dst] = src.fv[index];
+	fwx[dst] = src.fwx[index];
+	fwy[dst] = src.fwy[index];
+	fwz[dst] = src.fwz[index];
+	fsx[dst] = src.fsx[index];
+	fsy[dst] = src.fsy[index];
+#endif
+}
+
+size_t VertexArrays::GetSize(void) const
+{
+	return block ? NUM_ARRAYS * stride * sizeof(float) + VERTEX_ARRAYS_ALIGN - 1 : 0;
+}
+
+void VertexArrays::GetVertex(int index, Vertex *vertex) const
+{
+	vertex->coordsLocal = Vector3(x[index], y[index], z[index]);
+	vertex->coordsWorld = Vector3(wx[index], wy[index], wz[index]);
+	vertex->normal = Vector3(nx[index], ny[index], nz[index]);
+	vertex->texCoord.u = u[index];
+	vertex->texCoord.v = v[index];
+	vertex->scr[0] = sx[index];
+	vertex->scr[1] = sy[index];
+	vertex->clip = clip[index];
+#ifdef FIXED_PIPELINE
+	vertex->scrFixed[0] = fsx[index];
+	vertex->scrFixed[1] = fsy[index];
+	vertex->texFixed[0] = fu[index];
+	vertex->texFixed[1] = fv[index];
+#endif
+}
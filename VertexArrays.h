@@ -0,0 +1,93 @@
+/**
+* File : VertexArrays.h
+* Description : Vertices of a mesh stored as one array per component
+*
+* Author(s) : ALucchi
+* Date of creation : 17/10/2026
+* Modification(s) :
+*/
+
+#ifndef VERTEX_ARRAYS_H
+#define VERTEX_ARRAYS_H
+
+//-------------------------------------------------------------------- INCLUDES
+#include "defs.h"
+
+//---------------------------------------------------------------------- CONSTS
+
+// Every array starts on this boundary and is padded to a multiple of it, so
+// the transforms can process the vertices 4 or 8 at a time
+#define VERTEX_ARRAYS_ALIGN	32
+
+//--------------------------------------------------------------------- CLASSES
+
+/* Structure of arrays version of the Vertex array of a mesh. The transform
+	loops only read the positions and write the outputs, instead of pulling
+	whole Vertex structures through the cache.
+	The loaders write the inputs directly (Reserve, then Finish) and the
+	Renderer writes the outputs. Set, SetVertex and GetVertex convert from
+	and to Vertex structures, for the code which still works on them. */
+class VertexArrays
+{
+public:
+	int		numVerts;
+	int		stride;					// allocated size of each array (>= numVerts)
+
+	// Inputs
+	float		*x, *y, *z;				// local coordinates
+	float		*nx, *ny, *nz;			// normal
+	float		*u, *v;					// texture coordinates
+
+	// Outputs of the transform
+	float		*wx, *wy, *wz;			// world coordinates
+	float		*sx, *sy;				// screen coordinates
+	int		*clip;					// frustum planes the vertex is outside of
+
+#ifdef FIXED_PIPELINE
+	// 16.16 fixed point copies of the inputs, and the outputs of the fixed transform
+	int		*fx, *fy, *fz;			// local coordinates
+	int		*fu, *fv;				// texture coordinates
+	int		*fwx, *fwy, *fwz;		// world coordinates
+	int		*fsx, *fsy;				// screen coordinates
+#endif
+
+	VertexArrays(void);
+	~VertexArrays(void);
+
+	// Allocate the arrays for num vertices (content undefined)
+	void Alloc(int num);
+	void Free(void);
+
+	/* Make room for num vertices. The inputs of the numVerts first ones are
+		kept, the arrays are only reallocated if num is above stride */
+	void Reserve(int num);
+
+	// Set the inputs of the numVerts vertices to 0
+	void ClearInputs(void);
+
+	/* Called once the inputs of the numVerts vertices are written : pads the
+		arrays and computes the fixed point copies of the inputs */
+	void Finish(void);
+
+	// Allocate the arrays and copy the inputs of the specified vertices
+	void Set(const Vertex *verts, int num);
+
+	// Inputs of the index-th vertex (call Finish once they are all set)
+	void SetVertex(int index, const Vertex &vertex);
+
+	/* Copy the inputs and outputs the rasterizers read (texture coordinates,
+		world and screen coordinates, clip code) of the index-th vertex of src
+		to the dst-th vertex */
+	void CopyRaster(int dst, const VertexArrays &src, int index);
+
+	// Bytes allocated for the arrays
+	size_t GetSize(void) const;
+
+	// Inputs and outputs of the index-th vertex (col is not stored)
+	void GetVertex(int index, Vertex *vertex) const;
+
+private:
+	char		*block;					// all the arrays, as allocated
+};
+
+#endif // VERTEX_ARRAYS_H
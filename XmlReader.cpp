@@ -0,0 +1,370 @@
+/**
+* File : XmlReader.cpp
+* Description : Streaming (SAX style) XML parser
+*
+* Author(s) : ALucchi
+* Date of creation : 17/10/2026
+* Modification(s) :
+*/
+
+//-------------------------------------------------------------------- INCLUDES
+#include <stdlib.h>
+#include <string.h>
+#include "XmlReader.h"
+
+//------------------------------------------------------------------- FUNCTIONS
+
+static inline bool isSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static char* skipSpaces(char *p)
+{
+	while(isSpace(*p))
+		p++;
+	return p;
+}
+
+// First occurrence of s (len characters) in [from,last), NULL if none
+static char* findString(char *from, char *last, const char *s, int len)
+{
+	while(last - from >= len)
+	{
+		char *c = (char*)memchr(from, s[0], last - from - len + 1);
+		if(!c)
+			return NULL;
+		if(!memcmp(c, s, len))
+			return c;
+		from = c + 1;
+	}
+	return NULL;
+}
+
+/* Replace the predefined entities and the character references of s, in
+	place. The references to non ASCII characters become '?'. */
+static void decodeEntities(char *s)
+{
+	char *dst = strchr(s, '&');
+	if(!dst)
+		return;
+
+	char *src = dst;
+	while(*src)
+	{
+		if(*src != '&')
+		{
+			*dst++ = *src++;
+			continue;
+		}
+
+		char *semi = strchr(src, ';');
+		if(!semi)
+		{
+			*dst++ = *src++;
+			continue;
+		}
+
+		*semi = 0;
+		const char *e = src + 1;
+		char c;
+		if(!strcmp(e, "lt"))			c = '<';
+		else if(!strcmp(e, "gt"))	c = '>';
+		else if(!strcmp(e, "amp"))	c = '&';
+		else if(!strcmp(e, "quot"))	c = '"';
+		else if(!strcmp(e, "apos"))	c = '\'';
+		else if(e[0] == '#')
+		{
+			long code = (e[1] == 'x') ? strtol(e + 2, NULL, 16) : strtol(e + 1, NULL, 10);
+			c = (code > 0 && code < 128) ? (char)code : '?';
+		}
+		else
+		{
+			// Unknown entity, kept as is
+			*semi = ';';
+			*dst++ = *src++;
+			continue;
+		}
+
+		*dst++ = c;
+		src = semi + 1;
+	}
+	*dst = 0;
+}
+
+const char* XmlFindAttribute(const XmlAttribute *attributes, int numAttributes, const char *name)
+{
+	for(int i = 0; i < numAttributes; i++)
+	{
+		if(!strcmp(attributes[i].name, name))
+			return attributes[i].value;
+	}
+	return NULL;
+}
+
+//--------------------------------------------------------------------- CLASSES
+
+XmlReader::XmlReader(void)
+{
+	buffer = new char[XML_READER_BUFFER];
+	file = NULL;
+	begin = end = offset = 0;
+	error = XML_OK;
+	errorOffset = 0;
+}
+
+XmlReader::~XmlReader(void)
+{
+	if(file)
+		fclose(file);
+	delete[] buffer;
+}
+
+const char* XmlReader::GetErrorDesc(void) const
+{
+	switch(error)
+	{
+		case XML_OK:						return "no error";
+		case XML_ERROR_FILE:				return "can't read the file";
+		case XML_ERROR_SYNTAX:			return "syntax error";
+		case XML_ERROR_TAG_TOO_LONG:	return "tag too long";
+		case XML_ERROR_STOPPED:			return "stopped by the handler";
+		default:								return "unknown error";
+	}
+}
+
+long XmlReader::GetErrorOffset(void) const
+{
+	return errorOffset;
+}
+
+int XmlReader::fail(int code, const char *at)
+{
+	if(error == XML_OK)
+	{
+		error = code;
+		errorOffset = offset + (at - buffer);
+	}
+	return error;
+}
+
+/* Move the unparsed bytes to the start of the buffer and read the next ones.
+	Returns the number of bytes read, 0 at the end of the file or if the
+	buffer is full. */
+long XmlReader::fill(void)
+{
+	if(begin > 0)
+	{
+		memmove(buffer, buffer + begin, end - begin);
+		offset += begin;
+		end -= begin;
+		begin = 0;
+	}
+
+	if(end == XML_READER_BUFFER)
+		return 0;
+
+	long n = (long)fread(buffer + end, 1, XML_READER_BUFFER - end, file);
+	end += n;
+	return n;
+}
+
+/* The '>' closing the markup starting at start ('<'), NULL if it is not in
+	the buffer yet */
+char* XmlReader::findMarkupEnd(char *start, char *last) const
+{
+	static const char comment[] = "<!--";
+	static const char cdata[] = "<![CDATA[";
+	long n = last - start;
+	char *close;
+
+	// Wait for the whole opening sequence before deciding
+	if(n < (long)sizeof(cdata) - 1 && !memcmp(start, cdata, n))
+		return NULL;
+
+	if(n >= (long)sizeof(comment) - 1 && !memcmp(start, comment, sizeof(comment) - 1))
+	{
+		close = findString(start + 4, last, "-->", 3);
+		return close ? close + 2 : NULL;
+	}
+	if(n >= (long)sizeof(cdata) - 1 && !memcmp(start, cdata, sizeof(cdata) - 1))
+	{
+		close = findString(start + 9, last, "]]>", 3);
+		return close ? close + 2 : NULL;
+	}
+	if(n >= 2 && start[1] == '?')
+	{
+		close = findString(start + 2, last, "?>", 2);
+		return close ? close + 1 : NULL;
+	}
+
+	// Element : '>' outside of the attribute values
+	char quote = 0;
+	for(char *p = start + 1; p < last; p++)
+	{
+		if(quote)
+		{
+			if(*p == quote)
+				quote = 0;
+		}
+		else
+		if(*p == '"' || *p == '\'')
+			quote = *p;
+		else
+		if(*p == '>')
+			return p;
+	}
+	return NULL;
+}
+
+/* Parse the markup [start,close] and call the handler. The markup is
+	modified to terminate the strings. */
+bool XmlReader::parseElement(char *start, char *close, XmlHandler *handler, int *depth)
+{
+	char *p = start + 1;
+
+	if(*p == '/')
+	{
+		*close = 0;
+		char *name = p + 1;
+		for(p = name; *p && !isSpace(*p); p++);
+		*p = 0;
+
+		if(*depth == 0)
+		{
+			fail(XML_ERROR_SYNTAX, start);
+			return false;
+		}
+		(*depth)--;
+
+		if(!handler->EndElement(name))
+		{
+			fail(XML_ERROR_STOPPED, start);
+			return false;
+		}
+		return true;
+	}
+
+	// Comments, CDATA, declarations and processing instructions
+	if(*p == '!' || *p == '?')
+		return true;
+
+	bool empty = close[-1] == '/';
+	if(empty)
+		close[-1] = 0;
+	*close = 0;
+
+	char *name = p;
+	while(*p && !isSpace(*p))
+		p++;
+	if(*p)
+		*p++ = 0;
+	if(!*name)
+	{
+		fail(XML_ERROR_SYNTAX, start);
+		return false;
+	}
+
+	XmlAttribute attributes[XML_MAX_ATTRIBUTES];
+	int numAttributes = 0;
+
+	for(;;)
+	{
+		p = skipSpaces(p);
+		if(!*p)
+			break;
+
+		char *attrName = p;
+		while(*p && *p != '=' && !isSpace(*p))
+			p++;
+		char *nameEnd = p;
+		p = skipSpaces(p);
+		if(*p != '=')
+		{
+			fail(XML_ERROR_SYNTAX, start);
+			return false;
+		}
+		p = skipSpaces(p + 1);
+
+		char quote = *p;
+		char *value = p + 1;
+		char *valueEnd = (quote == '"' || quote == '\'') ? strchr(value, quote) : NULL;
+		if(!valueEnd)
+		{
+			fail(XML_ERROR_SYNTAX, start);
+			return false;
+		}
+		*nameEnd = 0;
+		*valueEnd = 0;
+		p = valueEnd + 1;
+
+		decodeEntities(value);
+		if(numAttributes < XML_MAX_ATTRIBUTES)
+		{
+			attributes[numAttributes].name = attrName;
+			attributes[numAttributes].value = value;
+			numAttributes++;
+		}
+	}
+
+	if(!handler->StartElement(name, attributes, numAttributes) ||
+		(empty && !handler->EndElement(name)))
+	{
+		fail(XML_ERROR_STOPPED, start);
+		return false;
+	}
+
+	if(!empty)
+		(*depth)++;
+	return true;
+}
+
+int XmlReader::Parse(const char *filename, XmlHandler *handler)
+{
+	begin = end = offset = 0;
+	error = XML_OK;
+	errorOffset = 0;
+
+	file = fopen(filename, "rb");
+	if(!file)
+		return fail(XML_ERROR_FILE, buffer);
+
+	int depth = 0;
+
+	while(error == XML_OK)
+	{
+		char *last = buffer + end;
+		char *start = (char*)memchr(buffer + begin, '<', end - begin);
+
+		// The text between the markups is skipped
+		if(!start)
+		{
+			begin = end;
+			if(fill() == 0)
+				break;
+			continue;
+		}
+
+		char *close = findMarkupEnd(start, last);
+		if(!close)
+		{
+			begin = start - buffer;
+			if(fill() == 0)
+				fail(end == XML_READER_BUFFER ? XML_ERROR_TAG_TOO_LONG : XML_ERROR_SYNTAX, buffer + begin);
+			continue;
+		}
+
+		parseElement(start, close, handler, &depth);
+		begin = close + 1 - buffer;
+	}
+
+	if(ferror(file))
+		fail(XML_ERROR_FILE, buffer + begin);
+	fclose(file);
+	file = NULL;
+
+	// Elements not closed
+	if(depth != 0)
+		fail(XML_ERROR_SYNTAX, buffer + end);
+	return error;
+}
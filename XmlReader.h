@@ -0,0 +1,92 @@
+/**
+* File : XmlReader.h
+* Description : Streaming (SAX style) XML parser
+*
+* Author(s) : ALucchi
+* Date of creation : 17/10/2026
+* Modification(s) :
+*/
+
+#ifndef XML_READER_H
+#define XML_READER_H
+
+//-------------------------------------------------------------------- INCLUDES
+#include <stdio.h>
+
+//---------------------------------------------------------------------- CONSTS
+
+// The file is read by chunks of this size, a tag has to fit in a chunk
+#define XML_READER_BUFFER		(64 * 1024)
+
+// Attributes reported per element, the next ones are ignored
+#define XML_MAX_ATTRIBUTES		16
+
+//----------------------------------------------------------------------- TYPES
+
+typedef struct
+{
+	const char	*name;
+	const char	*value;				// entities are decoded
+} XmlAttribute;
+
+//--------------------------------------------------------------------- CLASSES
+
+/* Receives the elements as they are read. The strings point in the buffer of
+	the reader and are only valid during the call. The callbacks return false
+	to stop the parsing. Text, comments and processing instructions are
+	skipped. */
+class XmlHandler
+{
+public:
+	virtual ~XmlHandler(void) {}
+
+	virtual bool StartElement(const char *name, const XmlAttribute *attributes, int numAttributes) = 0;
+
+	// Also called for the empty elements (<name/>)
+	virtual bool EndElement(const char *name) = 0;
+};
+
+/* Parse a file in a single pass, with a buffer of XML_READER_BUFFER bytes
+	whatever the size of the file. The document is not validated : the names
+	of the end tags are not checked, only that every element is closed. */
+class XmlReader
+{
+public:
+	enum XML_ERROR {
+		XML_OK,
+		XML_ERROR_FILE,			// can't open or read the file
+		XML_ERROR_SYNTAX,
+		XML_ERROR_TAG_TOO_LONG,	// a tag doesn't fit in the buffer
+		XML_ERROR_STOPPED};		// by the handler
+
+	XmlReader(void);
+	~XmlReader(void);
+
+	// Returns XML_OK or the error (XML_ERROR)
+	int Parse(const char *filename, XmlHandler *handler);
+
+	const char* GetErrorDesc(void) const;
+
+	// Position of the error in the file
+	long GetErrorOffset(void) const;
+
+private:
+	char		*buffer;
+	FILE		*file;
+	long		begin, end;			// unparsed bytes of the buffer
+	long		offset;				// position of buffer[0] in the file
+	int		error;
+	long		errorOffset;
+
+	long fill(void);
+	char* findMarkupEnd(char *start, char *last) const;
+	bool parseElement(char *start, char *close, XmlHandler *handler, int *depth);
+	int fail(int code, const char *at);
+};
+
+//------------------------------------------------------------------- FUNCTIONS
+
+// Value of the attribute name, NULL if the element doesn't have it
+const char* XmlFindAttribute(const XmlAttribute *attributes, int numAttributes, const char *name);
+
+#endif // XML_READER_H
@@ -18,6 +18,55 @@ double parseReal(const char* val)
    return atof(val);
 }
 
+/* Decimal numbers of at most 19 digits with a small exponent are converted
+	with one exact product or quotient of doubles, so the result is the
+	correctly rounded value, like atof. The other forms fall back to atof. */
+float parseFloat(const char* val)
+{
+	static const double powers[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+	const char *p = val;
+	while(*p == ' ' || *p == '\t')
+		p++;
+
+	bool negative = (*p == '-');
+	if(*p == '-' || *p == '+')
+		p++;
+
+	unsigned long long mantissa = 0;
+	int digits = 0, exponent = 0;
+
+	for(; *p >= '0' && *p <= '9'; p++, digits++)
+		mantissa = mantissa * 10 + (*p - '0');
+	if(*p == '.')
+	{
+		for(p++; *p >= '0' && *p <= '9'; p++, digits++, exponent--)
+			mantissa = mantissa * 10 + (*p - '0');
+	}
+	if(*p == 'e' || *p == 'E')
+	{
+		const char *e = p + 1;
+		bool negativeExp = (*e == '-');
+		if(*e == '-' || *e == '+')
+			e++;
+		int exp = 0;
+		for(; *e >= '0' && *e <= '9' && exp < 1000; e++)
+			exp = exp * 10 + (*e - '0');
+		exponent += negativeExp ? -exp : exp;
+	}
+
+	// The mantissa and the power of 10 must be exact doubles
+	if(digits == 0 || digits > 19 || mantissa > (1ULL << 53) ||
+		exponent < -22 || exponent > 22)
+		return (float)atof(val);
+
+	double d = (double)mantissa;
+	d = exponent < 0 ? d / powers[-exponent] : d * powers[exponent];
+	return (float)(negative ? -d : d);
+}
+
 int parseInt(const char* val)
 {
    return atoi(val);
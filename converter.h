@@ -15,6 +15,9 @@
 
 double parseReal(const char* val);
 
+// Same result as parseReal, without the locale and the overhead of atof
+float parseFloat(const char* val);
+
 int parseInt(const char* val);
 
 unsigned short getshort(unsigned char *source);
@@ -23,8 +23,11 @@
 
 //---------------------------------------------------------------------- CONSTS
 
-//#define BACK_FACE_CULLING
 //#define RENDERER_WIRE
+
+/* Vertex transform, projection, edge stepping and texture interpolation in
+	16.16 fixed point, for the CPUs without FPU (GP2X) */
+//#define FIXED_PIPELINE
 #define DEBUG
 
 #ifdef WIN32
@@ -79,6 +82,7 @@ NB : To be displayed on the screen, a pixel must have coordinates included in :
 #define ERR_PARSING_MESH		-10
 
 #define ERR_TINY_READING_FILE	-20
+#define ERR_READING_FILE		-21
 
 #define ERR_LOADING_BMP			-30
 #define ERR_LOADING_PALETTE	-31
@@ -100,6 +104,13 @@ enum TRIANGLE_TYPE {FLAT_BOTTOM, FLAT_TOP, GENERAL};
 #define SQUARE(x)		((x) * (x))
 #define CUBE(x)			((x) * (x) * (x))
 
+#ifndef MIN
+#define MIN(x, y)		((x) < (y) ? (x) : (y))
+#endif
+#ifndef MAX
+#define MAX(x, y)		((x) > (y) ? (x) : (y))
+#endif
+
 #define SWAP(t,x,y) {t=x;x=y;y=t;}
 #define SWAPINT(x, y) (x ^= y ^= x ^= y);
 
@@ -113,12 +124,16 @@ typedef unsigned int uint;
 
 // Screen's surface
 #if SCR_BPP == 8
-	typedef byte * Screen;	// 8 bits
+	typedef byte Pixel;		// 8 bits (palette index)
+	#define RGB_TO_PIXEL(r,g,b)	0
 #elif SCR_BPP == 16
-	typedef word * Screen;	// 16 bits
+	typedef word Pixel;		// 16 bits (RGB 565)
+	#define RGB_TO_PIXEL(r,g,b)	((((r) >> 3) << 11) | (((g) >> 2) << 5) | ((b) >> 3))
 #elif SCR_BPP == 32
-	typedef dword * Screen;	// 32 bits
+	typedef dword Pixel;		// 32 bits (XRGB)
+	#define RGB_TO_PIXEL(r,g,b)	(((r) << 16) | ((g) << 8) | (b))
 #endif
+typedef Pixel * Screen;
 
 // Color
 typedef struct L3DC_Color {
@@ -160,9 +175,15 @@ typedef struct {
 	Vertex_TexCoord texCoord;
 	float	scr[2];					// Screen coordinates
 	RGBA_F	col;				// point's color
+	int		clip;					// frustum planes the vertex is outside of
+#ifdef FIXED_PIPELINE
+	int		scrFixed[2];			// scr in 16.16 fixed point
+	int		texFixed[2];			// texCoord in 16.16 fixed point
+#endif
 } Vertex;
 
 typedef unsigned short TIndex;
+#define TINDEX_MAX		0xFFFF		// an object has at most TINDEX_MAX + 1 vertices
 
 // We should keep Triangle or Vertex but not both
 typedef struct {
@@ -175,6 +196,13 @@ typedef struct {
 	Vector3	normal;					// face normal
 } Triangle;
 
+// Bounding volumes of a mesh (local coordinates)
+typedef struct {
+	Vector3	min, max;				// axis aligned bounding box
+	Vector3	center;					// bounding sphere
+	float	radius;					// < 0 if not computed
+} Bounds;
+
 typedef struct {
 	int		verts[3];				// vertex indices
 	Vector3	normal;					// face normal